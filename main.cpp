@@ -10,12 +10,47 @@
 #include <stack>
 #include <iomanip>
 #include <cmath>
+#include <climits>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <random>
+#include <new>
+#include <memory>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 using namespace std;
 
-const int MAX_QUEUE_SIZE = 50;
-const int MAX_STACK_SIZE = 50;
-const int INITIAL_HASH_SIZE = 11;
+const int MAX_RECENT_FILES = 50;
+const int STARRED_DISPLAY_LIMIT = 20;
+const size_t FILE_PAGE_SIZE = 50;
+const size_t PARALLEL_SORT_THRESHOLD = 1 << 16;  // Folder sorts this large run on every core
+const int DEFAULT_TRASH_CAPACITY = 50;                  // Files kept in each folder's trash
+const int MAX_TRASH_CAPACITY = 1 << 20;
+const int64_t DEFAULT_TRASH_RETENTION = 30LL * 24 * 3600;  // Seconds a deleted file stays recoverable
+const int INITIAL_HASH_SIZE = 16;
 const string VERSION = "2.0.0 Ultimate";
 
 /**
@@ -35,15 +70,29 @@ string Trim(string s) {
     return s.substr(start, end - start + 1);
 }
 /**
- * @brief  Gets the current system time as a formatted string.
+ * @brief  Formats a point in time for display.
  * @return string YYYY-MM-DD HH:MM:SS
  */
-string CurrentTimestamp() {
-    time_t t = time(nullptr);
+string FormatTimestamp(time_t t) {
     char buf[64];
     strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&t));
     return string(buf);
 }
+
+
+/**
+ * @brief  Gets the current system time as a formatted string.
+ * @return string YYYY-MM-DD HH:MM:SS
+ */
+string CurrentTimestamp() { return FormatTimestamp(time(nullptr)); }
+
+/**
+ * @brief  Wall-clock time fine enough to order accesses made within one second.
+ * @return Microseconds since the Unix epoch.
+ */
+int64_t NowMicros() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
 /**
  * @brief Prints a decorative horizontal line.
  */
@@ -125,1779 +174,7468 @@ public:
 // Global logger instance
 SystemLogger sysLog;
 
-class FileVersion {
+/**
+ * @brief CRC-32 (IEEE) used to detect torn or corrupt journal records.
+ */
+uint32_t Crc32(const char* data, size_t len, uint32_t crc = 0) {
+    static const struct Table {
+        uint32_t v[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                v[i] = c;
+            }
+        }
+    } table;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = table.v[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Typed mutations recorded in the write-ahead journal
+enum JournalOp : uint8_t {
+    JOP_REGISTER = 1,      // user, password, question, answer
+    JOP_RESET_PASSWORD,    // user, new password
+    JOP_CREATE_FOLDER,     // user, folder ID, name
+    JOP_CREATE_FILE,       // user, folder ID, file ID, name, type, priority, content
+    JOP_DELETE_FILE,       // user, folder ID, file ID, deletion time
+    JOP_RECOVER_FILE,      // user, folder ID
+    JOP_ADD_FRIEND,        // user, friend
+    JOP_SHARE_FILE,        // sender, receiver, folder ID, file ID
+    JOP_EDIT_FILE,         // user, folder ID, file ID, new content
+    JOP_UPLOAD_BEGIN,      // user, folder ID, file ID, name, type, priority
+    JOP_UPLOAD_CHUNK,      // user, folder ID, file ID, hash, codec, raw size, compressed bytes ("" if already stored)
+    JOP_UPLOAD_COMMIT,     // user, folder ID, file ID, codec
+    JOP_TRASH_LIMITS,      // user, capacity, retention seconds
+    JOP_SET_PRIORITY,      // user, folder ID, file ID, priority
+    JOP_DELETE_FOLDER,     // user, folder ID
+    JOP_DELETE_USER,       // user
+    JOP_SHARE_BATCH        // sender, folder ID, file count, file IDs..., receiver count, receivers...
+};
+
+/**
+ * @class JournalRecord
+ * @brief Builds the payload of one journal record (varints and length-prefixed strings).
+ */
+class JournalRecord {
+private:
+    string bytes;
+
+    void PutVarint(uint64_t v) {
+        while (v >= 0x80) {
+            bytes += (char)(v | 0x80);
+            v >>= 7;
+        }
+        bytes += (char)v;
+    }
+
 public:
-    string content; 
-    string timestamp;
-    int versionNumber;
+    JournalRecord(JournalOp op) { bytes += (char)op; }
 
-    FileVersion(const string &c, int v) : content(c), versionNumber(v) {
-        timestamp = CurrentTimestamp();
+    JournalRecord& Int(int64_t v) {
+        PutVarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));  // Zigzag keeps small negatives short
+        return *this;
+    }
+
+    JournalRecord& Str(const string& s) {
+        PutVarint(s.size());
+        bytes += s;
+        return *this;
     }
+
+    const string& Bytes() const { return bytes; }
 };
 
 /**
- * @class VersionNode
- * @brief Node for Singly Linked List storing file versions
+ * @class JournalReader
+ * @brief Decodes the fields of one journal record in the order they were written.
  */
-class VersionNode {
+class JournalReader {
+private:
+    const string& bytes;
+    size_t pos;
+
+    bool GetVarint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && pos < bytes.size(); shift += 7) {
+            uint8_t b = bytes[pos++];
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
 public:
-    FileVersion data;
-    VersionNode* next;
-    
-    VersionNode(const FileVersion& v) : data(v), next(nullptr) {}
+    JournalReader(const string& b) : bytes(b), pos(1) {}
+
+    JournalOp Op() const { return (JournalOp)(uint8_t)bytes[0]; }
+
+    bool Int(int64_t& v) {
+        uint64_t u;
+        if (!GetVarint(u)) return false;
+        v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+        return true;
+    }
+
+    bool Int(int& v) {
+        int64_t wide;
+        if (!Int(wide)) return false;
+        v = (int)wide;
+        return true;
+    }
+
+    bool Str(string& s) {
+        uint64_t len;
+        if (!GetVarint(len) || len > bytes.size() - pos) return false;
+        s.assign(bytes, pos, len);
+        pos += len;
+        return true;
+    }
 };
 
 /**
- * @class VersionLinkedList
- * @brief Singly Linked List for file version history
+ * @class Journal
+ * @brief Append-only binary write-ahead log with group commit.
+ *
+ * Appends only copy the record into a buffer. A background flusher writes
+ * everything buffered since its last pass with one write and one fsync, so
+ * callers that append while an fsync is in flight share the next one.
+ * Record framing: [u32 length][u32 crc][u64 lsn][payload].
  */
-class VersionLinkedList {
+class Journal {
 private:
-    VersionNode* head;
-    int count;
-    
-    // Helper function to copy nodes
-    VersionNode* CopyNodes(VersionNode* source) {
-        if (!source) return nullptr;
-        VersionNode* newHead = new VersionNode(source->data);
-        VersionNode* current = newHead;
-        VersionNode* sourceCurrent = source->next;
-        
-        while (sourceCurrent) {
-            current->next = new VersionNode(sourceCurrent->data);
-            current = current->next;
-            sourceCurrent = sourceCurrent->next;
-        }
-        return newHead;
+    static constexpr const char* MAGIC = "GDWAL\0\0\1";
+    static const size_t HEADER_SIZE = 8;
+    static const size_t FRAME_SIZE = 16;
+    static const size_t MAX_PENDING = 16 * 1024 * 1024;  // Appenders wait for the flusher beyond this
+
+    FILE* fp;
+    string pending;           // Framed records not yet handed to the flusher
+    uint64_t nextLsn;         // LSN of the last appended record
+    uint64_t durableLsn;      // Highest LSN known to be on disk
+    uint64_t recordCount, syncCount;
+    bool stopping;
+    bool failed;              // A write or fsync failed; nothing after durableLsn is on disk
+
+    mutex mtx;
+    condition_variable wakeFlusher;
+    condition_variable durable;
+    thread flusher;
+
+    static bool SyncToDisk(FILE* f) {
+        if (fflush(f) != 0) return false;
+#if defined(_WIN32)
+        return _commit(_fileno(f)) == 0;
+#elif defined(__linux__)
+        return fdatasync(fileno(f)) == 0;
+#else
+        return fsync(fileno(f)) == 0;
+#endif
     }
-    
-    // Helper function to clear nodes
-    void Clear() {
-        while (head) {
-            VersionNode* temp = head;
-            head = head->next;
-            delete temp;
+
+    void FlushLoop() {
+        unique_lock<mutex> lock(mtx);
+        while (true) {
+            wakeFlusher.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) break;  // Stopping with nothing left
+
+            string batch;
+            batch.swap(pending);
+            uint64_t batchLsn = nextLsn;
+            bool wasFailed = failed;
+            lock.unlock();
+
+            // Once a write has failed the file may end in a torn record, so later
+            // batches are dropped rather than written after it
+            bool ok = !wasFailed && fwrite(batch.data(), 1, batch.size(), fp) == batch.size() && SyncToDisk(fp);
+
+            lock.lock();
+            if (ok) {
+                durableLsn = batchLsn;
+                syncCount++;
+            } else if (!wasFailed) {  // A dropped batch must not undo a Checkpoint's reset
+                failed = true;
+            }
+            durable.notify_all();
         }
-        count = 0;
     }
-    
+
+    static bool ReadFrame(FILE* f, uint64_t& lsn, string& payload) {
+        char frame[FRAME_SIZE];
+        if (fread(frame, 1, FRAME_SIZE, f) != FRAME_SIZE) return false;
+        uint32_t len, crc;
+        memcpy(&len, frame, 4);
+        memcpy(&crc, frame + 4, 4);
+        memcpy(&lsn, frame + 8, 8);
+        if (len == 0 || len > (1u << 30)) return false;
+        payload.resize(len);
+        if (fread(&payload[0], 1, len, f) != len) return false;
+        return Crc32(payload.data(), len, Crc32(frame + 8, 8)) == crc;
+    }
+
 public:
-    VersionLinkedList() : head(nullptr), count(0) {}
-    
-    // Copy constructor
-    VersionLinkedList(const VersionLinkedList& other) : head(nullptr), count(0) {
-        head = CopyNodes(other.head);
-        count = other.count;
+    Journal() : fp(nullptr), nextLsn(0), durableLsn(0), recordCount(0), syncCount(0), stopping(false), failed(false) {}
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+    ~Journal() { Close(); }
+
+    bool IsOpen() const { return fp != nullptr; }
+    uint64_t LastLsn() const { return nextLsn; }
+
+    /**
+     * @brief Passes every intact record with an LSN above afterLsn to visit,
+     *        one at a time. Reading stops at the first torn or corrupt record.
+     * @return Byte length of the intact prefix of the file (0 if missing).
+     */
+    static long Scan(const string& path, uint64_t afterLsn, const function<void(const string&)>& visit, uint64_t& lastLsn) {
+        lastLsn = afterLsn;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return 0;
+        char magic[HEADER_SIZE];
+        long valid = 0;
+        if (fread(magic, 1, HEADER_SIZE, f) == HEADER_SIZE && memcmp(magic, MAGIC, HEADER_SIZE) == 0) {
+            valid = HEADER_SIZE;
+            uint64_t lsn;
+            string payload;
+            while (ReadFrame(f, lsn, payload)) {
+                if (lsn > lastLsn) {
+                    visit(payload);
+                    lastLsn = lsn;
+                }
+                valid = ftell(f);
+            }
+        }
+        fclose(f);
+        return valid;
     }
-    
-    // Copy assignment operator
-    VersionLinkedList& operator=(const VersionLinkedList& other) {
-        if (this != &other) {
-            Clear();
-            head = CopyNodes(other.head);
-            count = other.count;
+
+    /**
+     * @brief Opens the journal for appending after recovery has replayed it.
+     * @param validBytes Intact prefix reported by Scan; anything after it is cut off.
+     */
+    bool Open(const string& path, long validBytes, uint64_t lastLsn) {
+        Close();
+        fp = fopen(path.c_str(), validBytes > 0 ? "r+b" : "w+b");
+        if (!fp) return false;
+        bool ok = true;
+        if (validBytes == 0) {
+            ok = fwrite(MAGIC, 1, HEADER_SIZE, fp) == HEADER_SIZE;
+            validBytes = HEADER_SIZE;
         }
-        return *this;
+        ok = ok && fflush(fp) == 0;
+#ifdef _WIN32
+        ok = ok && _chsize_s(_fileno(fp), validBytes) == 0;
+#else
+        ok = ok && ftruncate(fileno(fp), validBytes) == 0;
+#endif
+        ok = ok && fseek(fp, validBytes, SEEK_SET) == 0 && SyncToDisk(fp);
+        if (!ok) { fclose(fp); fp = nullptr; return false; }
+
+        nextLsn = durableLsn = lastLsn;
+        stopping = false;
+        failed = false;
+        flusher = thread(&Journal::FlushLoop, this);
+        return true;
     }
-    
-    ~VersionLinkedList() {
-        Clear();
+
+    /**
+     * @brief  Queues a record; does not wait for it to reach the disk.
+     * @return The record's LSN, or 0 if no journal is open or it has failed.
+     */
+    uint64_t Append(const JournalRecord& rec) {
+        if (!fp) return 0;
+        const string& payload = rec.Bytes();
+        uint32_t len = payload.size();
+
+        unique_lock<mutex> lock(mtx);
+        // Streaming uploads can outrun the disk; keep the buffer bounded
+        durable.wait(lock, [this] { return pending.size() < MAX_PENDING; });
+        if (failed) return 0;
+        uint64_t lsn = ++nextLsn;
+        char frame[FRAME_SIZE];
+        memcpy(frame, &len, 4);
+        memcpy(frame + 8, &lsn, 8);
+        uint32_t crc = Crc32(payload.data(), len, Crc32(frame + 8, 8));
+        memcpy(frame + 4, &crc, 4);
+        pending.append(frame, FRAME_SIZE);
+        pending += payload;
+        recordCount++;
+        wakeFlusher.notify_one();
+        return lsn;
     }
-    
-    void AddVersion(const FileVersion& v) {
-        VersionNode* newNode = new VersionNode(v);
-        newNode->next = head;  // Insert at front (LIFO - latest first)
-        head = newNode;
-        count++;
+
+    /**
+     * @brief  Blocks until every record appended so far is on disk.
+     * @return false if the journal failed first, so some of them never will be.
+     */
+    bool Sync() {
+        if (!fp) return true;
+        unique_lock<mutex> lock(mtx);
+        uint64_t target = nextLsn;
+        durable.wait(lock, [this, target] { return durableLsn >= target || failed; });
+        return durableLsn >= target;
     }
-    
-    FileVersion GetLatest() const {
-        return head ? head->data : FileVersion("", 0);
+
+    /**
+     * @brief  Empties the journal once a snapshot covering LastLsn() is safely
+     *         on disk. LSNs keep counting up from where they were. Also clears
+     *         a failure, since the snapshot now holds every dropped record.
+     * @return false if the file could not be truncated and synced.
+     */
+    bool Checkpoint() {
+        if (!fp) return true;
+        Sync();
+        lock_guard<mutex> lock(mtx);
+        fflush(fp);  // May fail after a write error; the truncate below discards it anyway
+#ifdef _WIN32
+        if (_chsize_s(_fileno(fp), HEADER_SIZE) != 0) return false;
+#else
+        if (ftruncate(fileno(fp), HEADER_SIZE) != 0) return false;
+#endif
+        clearerr(fp);
+        if (fseek(fp, HEADER_SIZE, SEEK_SET) != 0 || !SyncToDisk(fp)) return false;
+        pending.clear();
+        durableLsn = nextLsn;
+        failed = false;
+        return true;
     }
-    
-    int GetCount() const { return count; }
-    
-    void DisplayAll() const {
-        if (!head) {
-            cout << " No versions available.\n";
-            return;
-        }
-        VersionNode* current = head;
-        int verNum = count;
-        cout << " --- VERSION HISTORY (Linked List) ---\n";
-        while (current) {
-            cout << " Version " << verNum << " [" << current->data.timestamp << "]\n";
-            current = current->next;
-            verNum--;
+
+    void Close() {
+        if (!fp) return;
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
         }
+        wakeFlusher.notify_one();
+        if (flusher.joinable()) flusher.join();
+        fclose(fp);
+        fp = nullptr;
     }
-    
-    FileVersion GetVersion(int versionNum) const {
-        if (versionNum < 1 || versionNum > count) return FileVersion("", 0);
-        
-        VersionNode* current = head;
-        int pos = count;
-        while (current && pos != versionNum) {
-            current = current->next;
-            pos--;
-        }
-        return current ? current->data : FileVersion("", 0);
+
+    void DisplayStats() {
+        lock_guard<mutex> lock(mtx);
+        cout << " Journal: " << recordCount << " records committed with " << syncCount << " fsyncs";
+        if (syncCount) cout << " (" << fixed << setprecision(1) << (double)recordCount / syncCount << " per fsync)" << defaultfloat;
+        cout << "\n";
+        if (failed) cout << " [ERROR] A journal write failed; records after it were dropped.\n";
     }
 };
 
+// Global journal instance (closed until recovery finishes)
+Journal journal;
+
+// Waits for the journal and warns when changes made so far would not survive a crash
+void CommitJournal() {
+    if (!journal.Sync()) cerr << " [ERROR] Journal write failed; changes since the last save will not survive a crash.\n";
+}
+
+const int VERSION_KEYFRAME_INTERVAL = 16;  // Every Nth version stores full content
+
 /**
- * @class File
- * @brief Represents a single file entity with version control and metadata.
+ * @class BinaryDelta
+ * @brief Encodes a new version as COPY/INSERT operations against the previous one.
+ *
+ * Format: varint targetSize, then ops. Each op starts with varint
+ * (length << 1 | isCopy); a COPY is followed by a varint source offset,
+ * an INSERT by its literal bytes. Matching uses 16-byte blocks of the
+ * source found with a rolling hash, after trimming the common prefix and
+ * suffix, so the delta grows with the size of the edit, not of the file.
  */
-class File {
+class BinaryDelta {
 private:
-    int id;
-    string name;
-    string type;
-    string owner;
-    int sizeBytes;
-    int priority; // 1-10, for Heap
-    VersionLinkedList versions;  // Changed from vector to Linked List
-    vector<string> tags;
-        
-    string RLECompress(const string &s) {
-        if (s.empty()) return "";
-        string out;
-        for (size_t i = 0; i < s.size();) {
-            char c = s[i];
-            size_t j = i + 1;
-            while (j < s.size() && s[j] == c) ++j;
-            out += to_string(j - i) + string(1, c);
-            i = j;
+    static const size_t BLOCK = 16;
+    static const uint64_t HASH_BASE = 0x100000001B3ULL;
+
+    static void PutVarint(string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out += (char)(v | 0x80);
+            v >>= 7;
         }
-        return out;
+        out += (char)v;
+    }
+
+    static bool GetVarint(const string& in, size_t& pos, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            uint8_t b = in[pos++];
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static void EmitCopy(string& out, uint64_t offset, uint64_t len) {
+        if (len == 0) return;
+        PutVarint(out, len << 1 | 1);
+        PutVarint(out, offset);
     }
 
-    string RLEDecompress(const string &s) const {
+    static void EmitInsert(string& out, const char* data, uint64_t len) {
+        if (len == 0) return;
+        PutVarint(out, len << 1);
+        out.append(data, len);
+    }
+
+    static uint64_t BlockHash(const char* p) {
+        uint64_t h = 0;
+        for (size_t i = 0; i < BLOCK; i++) h = h * HASH_BASE + (uint8_t)p[i];
+        return h;
+    }
+
+public:
+    static string Encode(const string& base, const string& target) {
         string out;
-        size_t i = 0;
-        while (i < s.size()) {
-            int count = 0;
-            while (i < s.size() && isdigit(s[i])) {
-                count = count * 10 + (s[i] - '0');
-                ++i;
+        PutVarint(out, target.size());
+
+        size_t maxTrim = min(base.size(), target.size());
+        size_t prefix = 0;
+        while (prefix < maxTrim && base[prefix] == target[prefix]) prefix++;
+        size_t suffix = 0;
+        while (suffix < maxTrim - prefix &&
+               base[base.size() - 1 - suffix] == target[target.size() - 1 - suffix]) suffix++;
+
+        EmitCopy(out, 0, prefix);
+
+        // Middle sections that still differ
+        size_t bBegin = prefix, bEnd = base.size() - suffix;
+        size_t tBegin = prefix, tEnd = target.size() - suffix;
+
+        if (bEnd - bBegin >= BLOCK && tEnd - tBegin >= BLOCK) {
+            unordered_map<uint64_t, size_t> blocks;
+            blocks.reserve((bEnd - bBegin) / BLOCK);
+            for (size_t i = bBegin; i + BLOCK <= bEnd; i += BLOCK) {
+                blocks.emplace(BlockHash(base.data() + i), i);
             }
-            if (i < s.size()) {
-                char c = s[i++];
-                out.append(count, c);
+
+            uint64_t outPow = 1;  // HASH_BASE^(BLOCK-1), to roll the oldest byte out
+            for (size_t i = 1; i < BLOCK; i++) outPow *= HASH_BASE;
+
+            size_t literalStart = tBegin;
+            size_t t = tBegin;
+            uint64_t h = BlockHash(target.data() + t);
+            while (t + BLOCK <= tEnd) {
+                auto it = blocks.find(h);
+                if (it != blocks.end() && memcmp(base.data() + it->second, target.data() + t, BLOCK) == 0) {
+                    size_t src = it->second, dst = t, len = BLOCK;
+                    // Extend the match both ways
+                    while (dst > literalStart && src > bBegin && base[src - 1] == target[dst - 1]) {
+                        src--; dst--; len++;
+                    }
+                    while (dst + len < tEnd && src + len < bEnd && base[src + len] == target[dst + len]) len++;
+
+                    EmitInsert(out, target.data() + literalStart, dst - literalStart);
+                    EmitCopy(out, src, len);
+                    t = literalStart = dst + len;
+                    if (t + BLOCK <= tEnd) h = BlockHash(target.data() + t);
+                    continue;
+                }
+                if (t + BLOCK < tEnd) {
+                    h = (h - (uint8_t)target[t] * outPow) * HASH_BASE + (uint8_t)target[t + BLOCK];
+                }
+                t++;
             }
+            EmitInsert(out, target.data() + literalStart, tEnd - literalStart);
+        } else {
+            EmitInsert(out, target.data() + tBegin, tEnd - tBegin);
         }
+
+        EmitCopy(out, base.size() - suffix, suffix);
         return out;
     }
 
-public:
-    File() : id(0), sizeBytes(0), priority(0) {} 
-
-    void SetValues(int id_, const string &name_, const string &type_, const string &owner_, const string &content_, int prio = 1) {
-        id = id_;
-        name = name_;
-        type = type_;
-        owner = owner_;
-        priority = prio;
-        sizeBytes = content_.size();
-        AddVersion(content_);
+    // Returns false if the delta is corrupt or does not fit base
+    static bool Apply(const string& base, const string& delta, string& out) {
+        size_t pos = 0;
+        uint64_t targetSize, header, offset;
+        if (!GetVarint(delta, pos, targetSize)) return false;
+        out.clear();
+        out.reserve(targetSize);
+        while (pos < delta.size()) {
+            if (!GetVarint(delta, pos, header)) return false;
+            uint64_t len = header >> 1;
+            if (header & 1) {
+                if (!GetVarint(delta, pos, offset) || offset > base.size() || len > base.size() - offset) return false;
+                out.append(base, offset, len);
+            } else {
+                if (len > delta.size() - pos) return false;
+                out.append(delta, pos, len);
+                pos += len;
+            }
+        }
+        return out.size() == targetSize;
     }
+};
 
-    void AddVersion(const string &rawContent) {
-        string comp = RLECompress(rawContent);
-        int nextVer = versions.GetCount() + 1;
-        versions.AddVersion(FileVersion(comp, nextVer));
-        sizeBytes = (int)rawContent.size();
+/**
+ * @class Sha256
+ * @brief SHA-256 digest used as the identity of stored content chunks.
+ */
+class Sha256 {
+private:
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t blockLen;
+    uint64_t totalLen;
+
+    static uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void Compress(const uint8_t* p) {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
     }
 
-    string GetContent() const {
-        FileVersion latest = versions.GetLatest();
-        if (latest.versionNumber == 0) return "";
-        return RLEDecompress(latest.content);
-    }
-    
-    void DisplayVersionHistory() const {
-        versions.DisplayAll();
-    }
-    
-    int GetVersionCount() const {
-        return versions.GetCount();
+public:
+    struct Digest {
+        uint8_t bytes[32];
+        bool operator==(const Digest& o) const { return memcmp(bytes, o.bytes, 32) == 0; }
+    };
+
+    // The digest is already uniformly distributed, so its first word is a good bucket hash
+    struct DigestHash {
+        size_t operator()(const Digest& d) const {
+            size_t h;
+            memcpy(&h, d.bytes, sizeof(h));
+            return h;
+        }
+    };
+
+    Sha256() : blockLen(0), totalLen(0) {
+        static const uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        memcpy(state, init, sizeof(state));
     }
 
-    void DisplayDetailed() const {
-        PrintLine('.');
-        cout << " FILE DETAILS\n";
-        cout << " ID:       " << id << "\n";
-        cout << " Name:     " << name << "." << type << "\n";
-        cout << " Owner:    " << owner << "\n";
-        cout << " Priority: " << priority << "/10\n";
-        cout << " Size:     " << sizeBytes << " bytes\n";
-        cout << " Versions: " << versions.GetCount() << "\n";
-        cout << " Content:  " << GetContent() << "\n";
-        PrintLine('.');
+    void Update(const char* data, size_t len) {
+        const uint8_t* p = (const uint8_t*)data;
+        totalLen += len;
+        if (blockLen) {
+            size_t take = min(len, 64 - blockLen);
+            memcpy(block + blockLen, p, take);
+            blockLen += take; p += take; len -= take;
+            if (blockLen < 64) return;
+            Compress(block);
+            blockLen = 0;
+        }
+        for (; len >= 64; p += 64, len -= 64) Compress(p);
+        memcpy(block, p, len);
+        blockLen = len;
     }
 
-    void DisplayRow() const {
-        cout << " " << setw(5) << id << " | " << setw(15) << name << " | " << setw(5) << type << " | " << setw(5) << sizeBytes << "B | Prio: " << priority << endl;
+    Digest Finish() {
+        uint64_t bits = totalLen * 8;
+        uint8_t pad = 0x80;
+        Update((const char*)&pad, 1);
+        pad = 0;
+        while (blockLen != 56) Update((const char*)&pad, 1);
+        uint8_t lenBytes[8];
+        for (int i = 0; i < 8; i++) lenBytes[i] = (uint8_t)(bits >> (56 - 8 * i));
+        Update((const char*)lenBytes, 8);
+
+        Digest d;
+        for (int i = 0; i < 8; i++) {
+            d.bytes[4 * i] = state[i] >> 24;
+            d.bytes[4 * i + 1] = state[i] >> 16;
+            d.bytes[4 * i + 2] = state[i] >> 8;
+            d.bytes[4 * i + 3] = state[i];
+        }
+        return d;
     }
 
-    int GetID() const { return id; }
-    void SetID(int newID) { id = newID; } 
-    string GetName() const { return name; }
-    int GetSize() const { return sizeBytes; }
-    int GetPriority() const { return priority; }
+    static Digest Of(const char* data, size_t len) {
+        Sha256 s;
+        s.Update(data, len);
+        return s.Finish();
+    }
 };
 
+// Compression codecs, in the order adaptive selection prefers them (fastest first)
+enum CodecID : uint8_t { CODEC_STORED = 0, CODEC_RLE, CODEC_LZ, CODEC_HUFFMAN, CODEC_COUNT };
+
 /**
- * @class FileNode
- * @brief Node for Double Linked List for file navigation
+ * @class Codec
+ * @brief Interface every compression codec implements.
+ *        Callers keep the raw size, so formats do not repeat it.
  */
-class FileNode {
+class Codec {
 public:
-    File data;
-    FileNode* prev;
-    FileNode* next;
-    
-    FileNode(const File& f) : data(f), prev(nullptr), next(nullptr) {}
+    virtual ~Codec() {}
+    virtual const char* Name() const = 0;
+    // Appends the compressed form of in to out
+    virtual void Compress(const char* in, size_t n, string& out) const = 0;
+    // Writes exactly rawSize bytes to out; false if the input is corrupt
+    virtual bool Decompress(const char* in, size_t n, char* out, size_t rawSize) const = 0;
+};
+
+class StoredCodec : public Codec {
+public:
+    const char* Name() const override { return "Stored"; }
+
+    void Compress(const char* in, size_t n, string& out) const override { out.append(in, n); }
+
+    bool Decompress(const char* in, size_t n, char* out, size_t rawSize) const override {
+        if (n != rawSize) return false;
+        memcpy(out, in, n);
+        return true;
+    }
 };
 
 /**
- * @class FileDoubleLinkedList
- * @brief Double Linked List for sequential file browsing
+ * @class RleCodec
+ * @brief Byte-oriented run-length coding (PackBits layout) with SSE2 run scanning.
+ *
+ * Control byte c < 128: c + 1 literal bytes follow.
+ * Control byte c >= 128: the next byte repeats c - 125 times (3..130).
  */
-class FileDoubleLinkedList {
+class RleCodec : public Codec {
 private:
-    FileNode* head;
-    FileNode* tail;
-    FileNode* current;  // Current position for navigation
-    
-    // Helper to copy nodes
-    void CopyNodes(const FileDoubleLinkedList& other) {
-        if (!other.head) {
-            head = tail = current = nullptr;
-            return;
+    static constexpr size_t MAX_LITERAL = 128;
+    static const size_t MIN_RUN = 3;
+    static constexpr size_t MAX_RUN = 130;
+
+    // First position >= i that starts a run of MIN_RUN equal bytes, or n
+    static size_t FindRun(const uint8_t* p, size_t i, size_t n) {
+#ifdef __SSE2__
+        for (; i + 18 <= n; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 1));
+            __m128i c = _mm_loadu_si128((const __m128i*)(p + i + 2));
+            int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(b, c)));
+            if (mask) return i + __builtin_ctz(mask);
         }
-        
-        // Copy first node
-        head = new FileNode(other.head->data);
-        FileNode* otherCurrent = other.head->next;
-        FileNode* thisCurrent = head;
-        current = head;  // Set current to head initially
-        
-        // Copy remaining nodes
-        while (otherCurrent) {
-            thisCurrent->next = new FileNode(otherCurrent->data);
-            thisCurrent->next->prev = thisCurrent;
-            thisCurrent = thisCurrent->next;
-            otherCurrent = otherCurrent->next;
+#endif
+        for (; i + MIN_RUN <= n; i++) {
+            if (p[i] == p[i + 1] && p[i] == p[i + 2]) return i;
         }
-        
-        tail = thisCurrent;
+        return n;
     }
-    
-public:
-    FileDoubleLinkedList() : head(nullptr), tail(nullptr), current(nullptr) {}
-    
-    // Copy constructor
-    FileDoubleLinkedList(const FileDoubleLinkedList& other) : head(nullptr), tail(nullptr), current(nullptr) {
-        CopyNodes(other);
+
+    // Number of bytes from i that equal p[i]
+    static size_t RunLength(const uint8_t* p, size_t i, size_t n) {
+        size_t j = i + 1;
+#ifdef __SSE2__
+        __m128i v = _mm_set1_epi8((char)p[i]);
+        for (; j + 16 <= n; j += 16) {
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + j)), v));
+            if (mask != 0xFFFF) return j + __builtin_ctz(~mask) - i;
+        }
+#endif
+        while (j < n && p[j] == p[i]) j++;
+        return j - i;
     }
-    
-    // Copy assignment operator
-    FileDoubleLinkedList& operator=(const FileDoubleLinkedList& other) {
-        if (this != &other) {
-            Clear();
-            CopyNodes(other);
+
+    static void EmitLiterals(const uint8_t* p, size_t from, size_t to, string& out) {
+        while (from < to) {
+            size_t len = min(to - from, MAX_LITERAL);
+            out += (char)(len - 1);
+            out.append((const char*)p + from, len);
+            from += len;
         }
-        return *this;
-    }
-    
-    ~FileDoubleLinkedList() {
-        Clear();
     }
-    
-    void AddFile(const File& f) {
-        FileNode* newNode = new FileNode(f);
-        if (!head) {
-            head = tail = current = newNode;
-        } else {
-            tail->next = newNode;
-            newNode->prev = tail;
-            tail = newNode;
+
+public:
+    const char* Name() const override { return "RLE"; }
+
+    void Compress(const char* in, size_t n, string& out) const override {
+        const uint8_t* p = (const uint8_t*)in;
+        size_t literalStart = 0, i = 0;
+        while (i < n) {
+            size_t run = FindRun(p, i, n);
+            if (run >= n) break;
+            EmitLiterals(p, literalStart, run, out);
+
+            size_t len = RunLength(p, run, n);
+            while (len >= MIN_RUN) {
+                size_t take = min(len, MAX_RUN);
+                out += (char)(take + 125);
+                out += (char)p[run];
+                run += take;
+                len -= take;
+            }
+            literalStart = run;  // A 1-2 byte leftover joins the next literal
+            i = run + len;
         }
+        EmitLiterals(p, literalStart, n, out);
     }
-    
-    void Clear() {
-        FileNode* temp = head;
-        while (temp) {
-            FileNode* next = temp->next;
-            delete temp;
-            temp = next;
+
+    bool Decompress(const char* in, size_t n, char* out, size_t rawSize) const override {
+        const uint8_t* p = (const uint8_t*)in;
+        size_t ip = 0, op = 0;
+        while (ip < n) {
+            uint8_t c = p[ip++];
+            if (c < 128) {
+                size_t len = c + 1;
+                if (len > n - ip || len > rawSize - op) return false;
+                memcpy(out + op, p + ip, len);
+                ip += len;
+                op += len;
+            } else {
+                size_t len = c - 125;
+                if (ip >= n || len > rawSize - op) return false;
+                memset(out + op, p[ip++], len);
+                op += len;
+            }
         }
-        head = tail = current = nullptr;
+        return op == rawSize;
     }
-    
-    void BuildFromVector(const vector<File>& files) {
-        Clear();
-        for (const auto& f : files) {
-            AddFile(f);
-        }
-        current = head;  // Reset to beginning
+};
+
+/**
+ * @class LzCodec
+ * @brief LZ77 in the LZ4 block layout: greedy hash-table matching, 64 KiB window.
+ *
+ * Sequence: token (literal length << 4 | match length - 4), extra length
+ * bytes for either nibble equal to 15, literals, 16-bit offset. The last
+ * sequence has literals only.
+ */
+class LzCodec : public Codec {
+private:
+    static const int HASH_BITS = 14;
+    static const size_t MIN_MATCH = 4;
+    static const size_t LAST_LITERALS = 5;   // The tail is always emitted as literals
+    static const size_t MAX_OFFSET = 65535;
+
+    static uint32_t Read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
     }
-    
-    File* GetCurrent() { 
-        return current ? &current->data : nullptr; 
+
+    static uint32_t Hash(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); }
+
+    static void PutLength(string& out, size_t len) {
+        for (; len >= 255; len -= 255) out += (char)255;
+        out += (char)len;
     }
-    
-    File* GetNext() { 
-        if (current && current->next) {
-            current = current->next;
-            return &current->data;
-        }
-        return nullptr;
+
+    static void EmitSequence(string& out, const uint8_t* lit, size_t litLen, size_t offset, size_t matchLen) {
+        size_t m = matchLen ? matchLen - MIN_MATCH : 0;
+        out += (char)((min(litLen, (size_t)15) << 4) | min(m, (size_t)15));
+        if (litLen >= 15) PutLength(out, litLen - 15);
+        out.append((const char*)lit, litLen);
+        if (!matchLen) return;
+        out += (char)(offset & 0xFF);
+        out += (char)(offset >> 8);
+        if (m >= 15) PutLength(out, m - 15);
     }
-    
-    File* GetPrev() {
-        if (current && current->prev) {
-            current = current->prev;
-            return &current->data;
-        }
-        return nullptr;
+
+    static bool GetLength(const uint8_t* p, size_t n, size_t& ip, size_t& len) {
+        uint8_t b;
+        do {
+            if (ip >= n) return false;
+            b = p[ip++];
+            len += b;
+        } while (b == 255);
+        return true;
     }
-    
-    void Reset() { current = head; }
-    
-    bool HasNext() const { return current && current->next != nullptr; }
-    bool HasPrev() const { return current && current->prev != nullptr; }
-};
 
-/**
- * @class NotificationNode
- * @brief Node for Circular Linked List storing notifications
- */
-class NotificationNode {
 public:
-    string message;
-    NotificationNode* next;
-    
-    NotificationNode(const string& msg) : message(msg), next(nullptr) {}
+    const char* Name() const override { return "LZ"; }
+
+    void Compress(const char* in, size_t n, string& out) const override {
+        const uint8_t* p = (const uint8_t*)in;
+        size_t anchor = 0;
+        if (n > MIN_MATCH + LAST_LITERALS) {
+            vector<uint32_t> table(1 << HASH_BITS, 0);  // Position + 1; 0 means empty
+            size_t limit = n - LAST_LITERALS;
+            size_t i = 0;
+            while (i + MIN_MATCH <= limit) {
+                uint32_t h = Hash(Read32(p + i));
+                size_t cand = table[h];
+                table[h] = i + 1;
+                if (cand && i - (cand - 1) <= MAX_OFFSET && Read32(p + cand - 1) == Read32(p + i)) {
+                    size_t src = cand - 1;
+                    size_t len = MIN_MATCH;
+                    while (i + len < limit && p[src + len] == p[i + len]) len++;
+                    EmitSequence(out, p + anchor, i - anchor, i - src, len);
+                    i += len;
+                    anchor = i;
+                } else {
+                    i += 1 + ((i - anchor) >> 6);  // Skip faster through incompressible data
+                }
+            }
+        }
+        EmitSequence(out, p + anchor, n - anchor, 0, 0);
+    }
+
+    bool Decompress(const char* in, size_t n, char* out, size_t rawSize) const override {
+        const uint8_t* p = (const uint8_t*)in;
+        size_t ip = 0, op = 0;
+        while (ip < n) {
+            uint8_t token = p[ip++];
+            size_t litLen = token >> 4;
+            if (litLen == 15 && !GetLength(p, n, ip, litLen)) return false;
+            if (litLen > n - ip || litLen > rawSize - op) return false;
+            memcpy(out + op, p + ip, litLen);
+            ip += litLen;
+            op += litLen;
+            if (ip == n) break;  // Last sequence
+
+            if (n - ip < 2) return false;
+            size_t offset = p[ip] | (size_t)p[ip + 1] << 8;
+            ip += 2;
+            size_t matchLen = token & 15;
+            if (matchLen == 15 && !GetLength(p, n, ip, matchLen)) return false;
+            matchLen += MIN_MATCH;
+            if (offset == 0 || offset > op || matchLen > rawSize - op) return false;
+
+            char* dst = out + op;
+            const char* src = dst - offset;
+            if (offset >= matchLen) {
+                memcpy(dst, src, matchLen);
+            } else {
+                for (size_t k = 0; k < matchLen; k++) dst[k] = src[k];  // Overlapping copy repeats the pattern
+            }
+            op += matchLen;
+        }
+        return op == rawSize;
+    }
 };
 
 /**
- * @class CircularNotificationQueue
- * @brief Circular Linked List for notification management
+ * @class HuffmanCodec
+ * @brief Order-0 canonical Huffman coding with a single-lookup decode table.
+ *
+ * Layout: 128 bytes of 4-bit code lengths (one per byte value), then the
+ * bit stream, least significant bit first.
  */
-class CircularNotificationQueue {
+class HuffmanCodec : public Codec {
 private:
-    NotificationNode* tail;  // Points to last node (tail->next = head)
-    int count;
-    
-public:
-    CircularNotificationQueue() : tail(nullptr), count(0) {}
-    
-    ~CircularNotificationQueue() {
-        if (!tail) return;
-        
-        NotificationNode* current = tail->next;  // Start from head
-        NotificationNode* start = current;
-        
-        if (current) {
-            do {
-                NotificationNode* temp = current;
-                current = current->next;
-                delete temp;
-            } while (current != start);
+    static const int MAX_BITS = 12;
+
+    static void BuildLengths(const uint64_t* freq, uint8_t* lengths) {
+        uint64_t f[256];
+        memcpy(f, freq, sizeof(f));
+        while (true) {
+            // Nodes 0..255 are leaves; internal nodes are appended after them
+            vector<int> parent(512, -1);
+            priority_queue<pair<uint64_t, int>, vector<pair<uint64_t, int>>, greater<pair<uint64_t, int>>> pq;
+            for (int s = 0; s < 256; s++) {
+                if (f[s]) pq.push({f[s], s});
+            }
+            memset(lengths, 0, 256);
+            if (pq.size() == 1) {
+                lengths[pq.top().second] = 1;
+                return;
+            }
+            int next = 256;
+            while (pq.size() > 1) {
+                auto a = pq.top(); pq.pop();
+                auto b = pq.top(); pq.pop();
+                parent[a.second] = parent[b.second] = next;
+                pq.push({a.first + b.first, next++});
+            }
+            int maxLen = 0;
+            for (int s = 0; s < 256; s++) {
+                if (!f[s]) continue;
+                int depth = 0;
+                for (int x = s; parent[x] != -1; x = parent[x]) depth++;
+                lengths[s] = depth;
+                maxLen = max(maxLen, depth);
+            }
+            if (maxLen <= MAX_BITS) return;
+            for (int s = 0; s < 256; s++) {
+                if (f[s]) f[s] = (f[s] >> 1) | 1;  // Flatten the distribution and retry
+            }
         }
     }
-    
-    void AddNotification(const string& msg) {
-        NotificationNode* newNode = new NotificationNode(msg);
-        if (!tail) {
-            tail = newNode;
-            tail->next = tail;  // Points to itself (circular)
-        } else {
-            newNode->next = tail->next;  // New node points to head
-            tail->next = newNode;        // Old tail points to new node
-            tail = newNode;              // Update tail
+
+    // Canonical codes, bit-reversed so they can be written LSB first
+    static void BuildCodes(const uint8_t* lengths, uint16_t* codes) {
+        int countPerLen[MAX_BITS + 1] = {0};
+        for (int s = 0; s < 256; s++) countPerLen[lengths[s]]++;
+        countPerLen[0] = 0;
+        int nextCode[MAX_BITS + 2] = {0};
+        for (int len = 1, code = 0; len <= MAX_BITS; len++) {
+            code = (code + countPerLen[len - 1]) << 1;
+            nextCode[len] = code;
+        }
+        for (int s = 0; s < 256; s++) {
+            int len = lengths[s];
+            if (!len) continue;
+            int code = nextCode[len]++;
+            int rev = 0;
+            for (int b = 0; b < len; b++) rev |= ((code >> b) & 1) << (len - 1 - b);
+            codes[s] = rev;
         }
-        count++;
     }
-    
-    void DisplayAll() {
-        if (!tail) { 
-            cout << " No notifications.\n"; 
-            return; 
+
+public:
+    const char* Name() const override { return "Huffman"; }
+
+    void Compress(const char* in, size_t n, string& out) const override {
+        const uint8_t* p = (const uint8_t*)in;
+        uint64_t freq[256] = {0};
+        for (size_t i = 0; i < n; i++) freq[p[i]]++;
+        uint8_t lengths[256];
+        uint16_t codes[256] = {0};
+        BuildLengths(freq, lengths);
+        BuildCodes(lengths, codes);
+
+        for (int s = 0; s < 256; s += 2) out += (char)(lengths[s] | lengths[s + 1] << 4);
+
+        uint64_t acc = 0;
+        int bits = 0;
+        for (size_t i = 0; i < n; i++) {
+            acc |= (uint64_t)codes[p[i]] << bits;
+            bits += lengths[p[i]];
+            while (bits >= 8) {
+                out += (char)acc;
+                acc >>= 8;
+                bits -= 8;
+            }
         }
-        
-        NotificationNode* current = tail->next;  // Start from head
-        NotificationNode* start = current;
-        int idx = 1;
-        
-        cout << " --- NOTIFICATIONS (Circular Linked List) ---\n";
-        do {
-            cout << " [" << idx++ << "] " << current->message << endl;
-            current = current->next;
-        } while (current != start);  // Until we circle back
+        if (bits) out += (char)acc;
     }
-    
-    int GetCount() const { return count; }
-    
-    void Clear() {
-        if (!tail) return;
-        
-        NotificationNode* current = tail->next;
-        NotificationNode* start = current;
-        
-        if (current) {
-            do {
-                NotificationNode* temp = current;
-                current = current->next;
-                delete temp;
-            } while (current != start);
+
+    bool Decompress(const char* in, size_t n, char* out, size_t rawSize) const override {
+        if (n < 128) return false;
+        const uint8_t* p = (const uint8_t*)in;
+        uint8_t lengths[256];
+        for (int s = 0; s < 256; s += 2) {
+            lengths[s] = p[s / 2] & 15;
+            lengths[s + 1] = p[s / 2] >> 4;
+            if (lengths[s] > MAX_BITS || lengths[s + 1] > MAX_BITS) return false;
         }
-        
-        tail = nullptr;
-        count = 0;
+        uint16_t codes[256] = {0};
+        BuildCodes(lengths, codes);
+
+        // Every MAX_BITS-bit window maps straight to (symbol, code length)
+        vector<uint16_t> table(1 << MAX_BITS, 0);
+        for (int s = 0; s < 256; s++) {
+            int len = lengths[s];
+            if (!len) continue;
+            for (int k = codes[s]; k < (1 << MAX_BITS); k += 1 << len) table[k] = (uint16_t)(s | len << 8);
+        }
+
+        size_t ip = 128;
+        uint64_t acc = 0;
+        int bits = 0;
+        for (size_t op = 0; op < rawSize; op++) {
+            while (bits <= 56 && ip < n) {
+                acc |= (uint64_t)p[ip++] << bits;
+                bits += 8;
+            }
+            uint16_t entry = table[acc & ((1 << MAX_BITS) - 1)];
+            int len = entry >> 8;
+            if (len == 0 || len > bits) return false;
+            out[op] = (char)(entry & 0xFF);
+            acc >>= len;
+            bits -= len;
+        }
+        return true;
     }
 };
 
 /**
- * @class FileStack
- * @brief Implements LIFO structure for Deleted Files (Trash Bin).
+ * @class CodecRegistry
+ * @brief Looks codecs up by ID and picks one for a payload by sampling it.
  */
-class FileStack { 
-    int top;
-    File arr[MAX_STACK_SIZE];
+class CodecRegistry {
+private:
+    static const size_t SAMPLE_SLICE = 4096;
+
 public:
-    FileStack() : top(0) {}
-    
-    void Push(File f) { 
-        if(top < MAX_STACK_SIZE) {
-            arr[top++] = f; 
+    static const Codec& Get(CodecID id) {
+        static const StoredCodec stored;
+        static const RleCodec rle;
+        static const LzCodec lz;
+        static const HuffmanCodec huffman;
+        static const Codec* codecs[CODEC_COUNT] = {&stored, &rle, &lz, &huffman};
+        return *codecs[id < CODEC_COUNT ? id : CODEC_STORED];
+    }
+
+    /**
+     * @brief Compresses up to three 4 KiB slices (start, middle, end) with
+     *        every codec and keeps the smallest. A slower codec must beat a
+     *        faster one by 5% to be chosen, and anything saving less than
+     *        10% over the raw bytes is stored as is.
+     */
+    static CodecID Choose(const char* data, size_t n) {
+        if (n < 64) return CODEC_STORED;
+        string sample;
+        if (n <= 3 * SAMPLE_SLICE) {
+            sample.assign(data, n);
         } else {
-            cout << " [WARN] Trash bin full. Oldest deleted file overwritten.\n";
-            // Shift left to make space
-            for(int i=0; i<MAX_STACK_SIZE-1; i++) arr[i] = arr[i+1];
-            arr[MAX_STACK_SIZE-1] = f;
+            sample.append(data, SAMPLE_SLICE);
+            sample.append(data + n / 2 - SAMPLE_SLICE / 2, SAMPLE_SLICE);
+            sample.append(data + n - SAMPLE_SLICE, SAMPLE_SLICE);
         }
-    }
 
-    File Pop() { 
-        if(!IsEmpty()) return arr[--top]; 
-        return File(); 
+        CodecID best = CODEC_STORED;
+        size_t bestSize = sample.size() * 9 / 10;
+        string out;
+        for (int id = CODEC_RLE; id < CODEC_COUNT; id++) {
+            out.clear();
+            Get((CodecID)id).Compress(sample.data(), sample.size(), out);
+            if (out.size() < bestSize) {
+                best = (CodecID)id;
+                bestSize = out.size() * 95 / 100;
+            }
+        }
+        return best;
     }
 
-    bool IsEmpty() const { return top == 0; }
-    
-    void EmptyTrash() {
-        top = 0;
-        cout << " Trash bin emptied.\n";
+    /**
+     * @brief  Appends data compressed with the preferred codec, or stored if
+     *         that does not make it smaller.
+     * @return The codec actually used.
+     */
+    static CodecID Compress(CodecID preferred, const char* data, size_t n, string& out) {
+        size_t start = out.size();
+        if (preferred != CODEC_STORED) {
+            Get(preferred).Compress(data, n, out);
+            if (out.size() - start < n) return preferred;
+            out.resize(start);
+        }
+        out.append(data, n);
+        return CODEC_STORED;
     }
 
-    void Display() const {
-        if(IsEmpty()) { cout << " (Trash is empty)\n"; return; }
-        for (int i = top-1; i >= 0; i--) {
-            cout << " [" << i+1 << "] " << arr[i].GetName() << " (ID: " << arr[i].GetID() << ")\n";
+    // Appends rawSize decompressed bytes to out
+    static bool Decompress(CodecID id, const string& in, size_t rawSize, string& out) {
+        size_t start = out.size();
+        out.resize(start + rawSize);
+        if (!Get(id).Decompress(in.data(), in.size(), &out[start], rawSize)) {
+            out.resize(start);
+            return false;
         }
+        return true;
     }
 };
 
+const size_t CHUNK_MIN_SIZE = 2 * 1024;
+const size_t CHUNK_AVG_SIZE = 8 * 1024;
+const size_t CHUNK_MAX_SIZE = 64 * 1024;
+
 /**
- * @class FileQueue
- * @brief Implements FIFO structure for Recent Files history.
+ * @class ContentChunker
+ * @brief Content-defined chunking with a Gear rolling hash (FastCDC style).
+ *
+ * A boundary depends only on the bytes since the previous one, so an edit
+ * moves at most the boundaries around it and every other chunk of the file
+ * keeps its hash. A stricter mask before the average size and a looser one
+ * after it keeps chunk sizes close to CHUNK_AVG_SIZE.
  */
-class FileQueue { 
-    int front, rear;
-    File arr[MAX_QUEUE_SIZE];
-    int count;
-public:
-    FileQueue() : front(0), rear(0), count(0) {}
-    
-    void Enqueue(File f) {
-        arr[rear] = f;
-        rear = (rear + 1) % MAX_QUEUE_SIZE;
-        if (count < MAX_QUEUE_SIZE) count++;
-        else front = (front + 1) % MAX_QUEUE_SIZE; 
+class ContentChunker {
+private:
+    static const uint64_t MASK_STRICT = 0x0000d9f003530000ULL;  // 15 bits set
+    static const uint64_t MASK_LOOSE = 0x0000d90003530000ULL;   // 11 bits set
+
+    static const uint64_t* Gear() {
+        static const struct Table {
+            uint64_t v[256];
+            Table() {
+                uint64_t x = 0x9E3779B97F4A7C15ULL;  // splitmix64, fixed seed: boundaries must never change
+                for (int i = 0; i < 256; i++) {
+                    x += 0x9E3779B97F4A7C15ULL;
+                    uint64_t z = x;
+                    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                    v[i] = z ^ (z >> 31);
+                }
+            }
+        } table;
+        return table.v;
     }
 
-    void Display() const {
-        if (count == 0) { cout << " (No recent files)\n"; return; }
-        int idx = front;
-        for(int i=0; i<count; i++) {
-            cout << "  " << i+1 << ". " << arr[idx].GetName() << " (Accessed: " << CurrentTimestamp() << ")\n";
-            idx = (idx + 1) % MAX_QUEUE_SIZE;
+public:
+    /**
+     * @brief  Length of the next chunk at the start of data.
+     * @param  final True if no more bytes follow data (the tail becomes a chunk).
+     * @return 0 if more bytes are needed before a boundary can be decided.
+     */
+    static size_t NextCut(const char* data, size_t len, bool final) {
+        if (len <= CHUNK_MIN_SIZE) return final ? len : 0;
+        const uint64_t* gear = Gear();
+        const uint8_t* p = (const uint8_t*)data;
+        size_t limit = min(len, CHUNK_MAX_SIZE);
+        size_t normal = min(limit, CHUNK_AVG_SIZE);
+        uint64_t h = 0;
+        size_t i = CHUNK_MIN_SIZE;
+        for (; i < normal; i++) {
+            h = (h << 1) + gear[p[i]];
+            if (!(h & MASK_STRICT)) return i + 1;
         }
+        for (; i < limit; i++) {
+            h = (h << 1) + gear[p[i]];
+            if (!(h & MASK_LOOSE)) return i + 1;
+        }
+        return (limit == CHUNK_MAX_SIZE || final) ? limit : 0;
     }
 };
 
 /**
- * @class FileMaxHeap
- * @brief Manages "Starred" or High Priority files.
+ * @class ChunkStore
+ * @brief Deduplicated, reference-counted storage of content chunks keyed by SHA-256.
+ *        Each chunk is kept compressed with the codec chosen for the version
+ *        that first stored it.
  */
-class FileMaxHeap {
+class ChunkStore {
+    friend class DriveSnapshot;
 private:
-    vector<File> heap;
-
-    int Parent(int i) { return (i - 1) / 2; }
-    int Left(int i) { return (2 * i + 1); }
-    int Right(int i) { return (2 * i + 2); }
-
-    void HeapifyDown(int i) {
-        int l = Left(i);
-        int r = Right(i);
-        int largest = i;
-
-        if (l < heap.size() && heap[l].GetPriority() > heap[largest].GetPriority())
-            largest = l;
-        if (r < heap.size() && heap[r].GetPriority() > heap[largest].GetPriority())
-            largest = r;
+    struct Chunk {
+        Sha256::Digest hash;
+        string data;       // Compressed bytes
+        uint32_t rawSize;
+        CodecID codec;
+        uint32_t refs;
+    };
+    vector<Chunk> chunks;
+    vector<uint32_t> freeIDs;
+    unordered_map<Sha256::Digest, uint32_t, Sha256::DigestHash> index;
+    uint64_t logicalBytes;  // Bytes as seen by files, counting every reference
+
+    uint32_t Insert(const Sha256::Digest& hash, string&& encoded, uint32_t rawSize, CodecID codec) {
+        uint32_t id;
+        if (!freeIDs.empty()) {
+            id = freeIDs.back();
+            freeIDs.pop_back();
+        } else {
+            id = chunks.size();
+            chunks.emplace_back();
+        }
+        Chunk& c = chunks[id];
+        c.hash = hash;
+        c.data = move(encoded);
+        c.rawSize = rawSize;
+        c.codec = codec;
+        c.refs = 0;
+        index.emplace(hash, id);
+        return id;
+    }
 
-        if (largest != i) {
-            swap(heap[i], heap[largest]);
-            HeapifyDown(largest);
+public:
+    ChunkStore() : logicalBytes(0) {}
+
+    // Stores one chunk (or finds an identical one) and takes a reference to it
+    uint32_t Put(const char* data, size_t len, CodecID codec) {
+        Sha256::Digest hash = Sha256::Of(data, len);
+        auto it = index.find(hash);
+        uint32_t id;
+        if (it != index.end()) {
+            id = it->second;
+        } else {
+            string encoded;
+            CodecID used = CodecRegistry::Compress(codec, data, len, encoded);
+            encoded.shrink_to_fit();  // Codecs grow their output; do not keep the slack
+            id = Insert(hash, move(encoded), (uint32_t)len, used);
         }
+        AddRef(id);
+        return id;
     }
 
-    void HeapifyUp(int i) {
-        if (i && heap[Parent(i)].GetPriority() < heap[i].GetPriority()) {
-            swap(heap[i], heap[Parent(i)]);
-            HeapifyUp(Parent(i));
+    /**
+     * @brief Journal replay: takes a reference to the chunk with this hash,
+     *        storing the already-compressed bytes if it is not present yet.
+     * @return false if the chunk is missing and no bytes were supplied.
+     */
+    bool PutEncoded(const Sha256::Digest& hash, const string& encoded, uint32_t rawSize, CodecID codec, uint32_t& id) {
+        auto it = index.find(hash);
+        if (it != index.end()) {
+            id = it->second;
+        } else {
+            if (encoded.empty() || rawSize == 0) return false;
+            id = Insert(hash, string(encoded), rawSize, codec);
         }
+        AddRef(id);
+        return true;
     }
 
-public:
-    void Insert(File f) {
-        heap.push_back(f);
-        HeapifyUp(heap.size() - 1);
+    void AddRef(uint32_t id) {
+        chunks[id].refs++;
+        logicalBytes += chunks[id].rawSize;
     }
 
-    void DisplayTop() {
-        if (heap.empty()) { cout << " No starred files.\n"; return; }
-        
-        // Sort a copy for display without ruining heap structure
-        vector<File> temp = heap;
-        sort(temp.begin(), temp.end(), [](File a, File b){
-            return a.GetPriority() > b.GetPriority();
-        });
+    void Release(uint32_t id) {
+        Chunk& c = chunks[id];
+        logicalBytes -= c.rawSize;
+        if (--c.refs == 0) {
+            index.erase(c.hash);
+            string().swap(c.data);
+            c.rawSize = 0;
+            freeIDs.push_back(id);
+        }
+    }
 
-        cout << " --- STARRED FILES (High Priority) ---\n";
-        for (const auto& f : temp) {
-            cout << " [Prio " << f.GetPriority() << "] " << f.GetName() << "\n";
+    uint32_t Size(uint32_t id) const { return chunks[id].rawSize; }
+    uint32_t Refs(uint32_t id) const { return chunks[id].refs; }
+    const Sha256::Digest& Hash(uint32_t id) const { return chunks[id].hash; }
+    CodecID Codec(uint32_t id) const { return chunks[id].codec; }
+    const string& Encoded(uint32_t id) const { return chunks[id].data; }
+
+    // Appends the chunk's decompressed bytes to out
+    bool Read(uint32_t id, string& out) const {
+        const Chunk& c = chunks[id];
+        return CodecRegistry::Decompress(c.codec, c.data, c.rawSize, out);
+    }
+
+    // Drops chunks that were restored from a snapshot but never referenced
+    void PurgeUnreferenced() {
+        for (uint32_t id = 0; id < chunks.size(); id++) {
+            if (chunks[id].refs == 0 && chunks[id].rawSize != 0) {
+                index.erase(chunks[id].hash);
+                string().swap(chunks[id].data);
+                chunks[id].rawSize = 0;
+                freeIDs.push_back(id);
+            }
         }
     }
 
-    File ExtractMax() {
-        if (heap.empty()) return File();
-        File root = heap[0];
-        heap[0] = heap.back();
-        heap.pop_back();
-        HeapifyDown(0);
-        return root;
+    void DisplayStats() const {
+        uint64_t uniqueBytes = 0, storedBytes = 0;
+        size_t perCodec[CODEC_COUNT] = {0};
+        for (const Chunk& c : chunks) {
+            if (c.rawSize == 0) continue;
+            uniqueBytes += c.rawSize;
+            storedBytes += c.data.size();
+            perCodec[c.codec]++;
+        }
+        cout << " Chunk store: " << index.size() << " unique chunks, " << uniqueBytes
+             << " bytes stored for " << logicalBytes << " bytes of file content";
+        if (uniqueBytes) cout << " (" << fixed << setprecision(2) << (double)logicalBytes / uniqueBytes << "x dedup)" << defaultfloat;
+        cout << "\n Compressed:  " << storedBytes << " bytes on disk";
+        if (storedBytes) cout << " (" << fixed << setprecision(2) << (double)uniqueBytes / storedBytes << "x)" << defaultfloat;
+        cout << " |";
+        for (int id = 0; id < CODEC_COUNT; id++) cout << " " << CodecRegistry::Get((CodecID)id).Name() << ": " << perCodec[id];
+        cout << "\n";
     }
 };
 
+// Global chunk store shared by every user's files
+ChunkStore chunkStore;
+
 /**
- * @class HashTableFiles
- * @brief Stores files in a folder using Linear Probing for collision resolution.
+ * @class ChunkList
+ * @brief A file's content as an ordered list of chunk references.
+ *        Copies take extra references instead of copying bytes.
  */
-class HashTableFiles {
+class ChunkList {
 private:
-    int capacity;
-    int currentSize;
-    File* arr;
-
-    int HashFunction(int key) { return key % capacity; }
-
-    void Resize() {
-        int oldCapacity = capacity;
-        File* oldArr = arr;
-        
-        capacity = capacity * 2; 
-        arr = new File[capacity];
-        currentSize = 0;
+    vector<uint32_t> ids;
+    uint64_t totalSize;
 
-        for (int i = 0; i < oldCapacity; i++) {
-            if (oldArr[i].GetID() > 0) { 
-                Insert(oldArr[i]);
-            }
+public:
+    ChunkList() : totalSize(0) {}
+
+    // Splits content at content-defined boundaries and stores each new chunk compressed with codec
+    ChunkList(const string& content, CodecID codec) : totalSize(0) {
+        size_t pos = 0;
+        while (pos < content.size()) {
+            size_t len = ContentChunker::NextCut(content.data() + pos, content.size() - pos, true);
+            Append(chunkStore.Put(content.data() + pos, len, codec));
+            pos += len;
         }
-        delete[] oldArr;
-        // sysLog.Log("System", "Hash Table Resized to " + to_string(capacity));
     }
 
-public:
-    HashTableFiles(int cap = INITIAL_HASH_SIZE) : capacity(cap), currentSize(0) {
-        arr = new File[capacity];
+    ChunkList(const ChunkList& other) : ids(other.ids), totalSize(other.totalSize) {
+        for (uint32_t id : ids) chunkStore.AddRef(id);
     }
 
-    // Copy constructor - CRITICAL: Prevents shallow copy crashes
-    HashTableFiles(const HashTableFiles& other) : capacity(other.capacity), currentSize(other.currentSize) {
-        arr = new File[capacity];
-        for (int i = 0; i < capacity; i++) {
-            arr[i] = other.arr[i];  // Deep copy each File
-        }
+    ChunkList(ChunkList&& other) noexcept : ids(move(other.ids)), totalSize(other.totalSize) {
+        other.ids.clear();
+        other.totalSize = 0;
     }
 
-    // Copy assignment operator - CRITICAL: Prevents shallow copy crashes
-    HashTableFiles& operator=(const HashTableFiles& other) {
-        if (this != &other) {
-            delete[] arr;  // Free existing memory
-            capacity = other.capacity;
-            currentSize = other.currentSize;
-            arr = new File[capacity];
-            for (int i = 0; i < capacity; i++) {
-                arr[i] = other.arr[i];  // Deep copy each File
-            }
-        }
+    ChunkList& operator=(ChunkList other) {
+        swap(ids, other.ids);
+        swap(totalSize, other.totalSize);
         return *this;
     }
 
-    ~HashTableFiles() { 
-        if (arr) {
-            delete[] arr;
-            arr = nullptr;
-        }
+    ~ChunkList() {
+        for (uint32_t id : ids) chunkStore.Release(id);
     }
 
-    void Insert(File f) {
-        if (currentSize >= capacity * 0.7) Resize();
+    // Takes ownership of a reference the caller already holds
+    void Append(uint32_t id) {
+        ids.push_back(id);
+        totalSize += chunkStore.Size(id);
+    }
 
-        int idx = HashFunction(f.GetID());
-        int startIdx = idx;
-        
-        while (arr[idx].GetID() > 0) { 
-            if (arr[idx].GetID() == f.GetID()) {
-                cout << " [Error] Duplicate File ID.\n";
-                return;
-            }
-            idx = (idx + 1) % capacity;
-            if (idx == startIdx) return; // Should not happen due to resize
+    // Reassembles the content; empty if a chunk fails to decompress
+    string Read() const {
+        string out;
+        out.reserve(totalSize);
+        for (uint32_t id : ids) {
+            if (!chunkStore.Read(id, out)) return "";
         }
-        
-        arr[idx] = f;
-        currentSize++;
+        return out;
     }
 
-    File* Search(int id) {
-        int idx = HashFunction(id);
-        int startIdx = idx;
-        
-        while (arr[idx].GetID() != 0) { 
-            if (arr[idx].GetID() == id) return &arr[idx]; 
-            idx = (idx + 1) % capacity;
-            if (idx == startIdx) break; 
-        }
-        return nullptr;
-    }
+    const vector<uint32_t>& IDs() const { return ids; }
+    uint64_t Size() const { return totalSize; }
+};
 
-    File Delete(int id) {
-        int idx = HashFunction(id);
-        int startIdx = idx;
+const size_t FILE_IO_BLOCK = 1024 * 1024;                  // Read/write granularity for disk transfers
+const uint64_t FILE_DELTA_MAX_SIZE = 4 * 1024 * 1024;      // Larger versions are always keyframes
+const size_t FILE_PREVIEW_BYTES = 1024;                    // Content shown on screen
 
-        while (arr[idx].GetID() != 0) {
-            if (arr[idx].GetID() == id) {
-                File temp = arr[idx];
-                arr[idx].SetID(-1); // Tombstone
-                currentSize--;
-                return temp;
+/**
+ * @class FileWriter
+ * @brief Ingests content of any length piece by piece and cuts it into
+ *        stored chunks as it goes. Only the bytes after the last boundary
+ *        are buffered, so memory stays bounded by the write size plus one
+ *        maximum chunk.
+ */
+class FileWriter {
+private:
+    string buffer;       // Bytes not yet cut into chunks (from consumed on)
+    size_t consumed;
+    ChunkList content;
+    CodecID codec;
+    bool codecChosen;
+    function<void(uint32_t)> onChunk;
+
+    void Cut(bool final) {
+        while (consumed < buffer.size()) {
+            const char* p = buffer.data() + consumed;
+            size_t avail = buffer.size() - consumed;
+            if (!codecChosen) {
+                codec = CodecRegistry::Choose(p, avail);  // Sampled from the start of the stream
+                codecChosen = true;
             }
-            idx = (idx + 1) % capacity;
-            if (idx == startIdx) break;
+            size_t len = ContentChunker::NextCut(p, avail, final);
+            if (len == 0) break;
+            uint32_t id = chunkStore.Put(p, len, codec);
+            content.Append(id);
+            if (onChunk) onChunk(id);
+            consumed += len;
+        }
+        if (consumed > buffer.size() / 2) {
+            buffer.erase(0, consumed);
+            consumed = 0;
         }
-        return File();
     }
 
-    void DisplayAll() {
-        if (currentSize == 0) { cout << " (Folder is empty)\n"; return; }
-        
-        cout << " ---------------------------------------------------------\n";
-        cout << "   ID  |      NAME       | TYPE  | SIZE   | PRIORITY \n";
-        cout << " ---------------------------------------------------------\n";
-        for (int i = 0; i < capacity; i++) {
-            if (arr[i].GetID() > 0) {
-                arr[i].DisplayRow();
-            }
-        }
-        cout << " ---------------------------------------------------------\n";
+public:
+    // onChunk is called with each chunk as soon as it is stored
+    FileWriter(function<void(uint32_t)> callback = nullptr)
+        : consumed(0), codec(CODEC_STORED), codecChosen(false), onChunk(callback) {}
+
+    void Write(const char* data, size_t len) {
+        buffer.append(data, len);
+        if (buffer.size() - consumed >= CHUNK_MAX_SIZE) Cut(false);
     }
 
-    // Helper to get vector for sorting
-    vector<File> GetFilesVector() {
-        vector<File> v;
-        for(int i=0; i<capacity; i++) {
-            if(arr[i].GetID() > 0) v.push_back(arr[i]);
-        }
-        return v;
+    // Stores the tail and hands over the finished content
+    ChunkList Finish() {
+        Cut(true);
+        string().swap(buffer);
+        consumed = 0;
+        return move(content);
     }
 
-    // 1. Bubble Sort (Size)
-    void SortBubbleSize() {
-        vector<File> v = GetFilesVector();
-        for (size_t i = 0; i < v.size() - 1; i++)
-            for (size_t j = 0; j < v.size() - i - 1; j++)
-                if (v[j].GetSize() > v[j+1].GetSize())
-                    swap(v[j], v[j+1]);
+    CodecID Codec() const { return codec; }
+    uint64_t Size() const { return content.Size() + (buffer.size() - consumed); }
+};
 
-        cout << "\n [SORTED BY SIZE (BUBBLE SORT)]\n";
-        for(auto& f : v) f.DisplayRow();
+/**
+ * @class FileReader
+ * @brief Reads one version of a file sequentially or at any 64-bit offset,
+ *        decompressing a single chunk at a time. Holds its own references,
+ *        so the content stays readable even if the file changes meanwhile.
+ */
+class FileReader {
+private:
+    ChunkList chunks;
+    string inlineContent;       // Delta versions, rebuilt in memory (at most FILE_DELTA_MAX_SIZE)
+    bool isInline;
+    vector<uint64_t> starts;    // Offset of each chunk
+    size_t nextChunk;
+    size_t cachedChunk;
+    string cache;
+
+    bool Load(size_t index) {
+        if (index == cachedChunk) return true;
+        cache.clear();
+        if (!chunkStore.Read(chunks.IDs()[index], cache)) return false;
+        cachedChunk = index;
+        return true;
     }
 
-    // 2. Quick Sort (Name)
-    int Partition(vector<File>& v, int low, int high) {
-        string pivot = v[high].GetName();
-        int i = (low - 1);
-        for (int j = low; j <= high - 1; j++) {
-            if (v[j].GetName() < pivot) {
-                i++;
-                swap(v[i], v[j]);
-            }
+public:
+    explicit FileReader(const ChunkList& content)
+        : chunks(content), isInline(false), nextChunk(0), cachedChunk(SIZE_MAX) {
+        uint64_t offset = 0;
+        starts.reserve(chunks.IDs().size());
+        for (uint32_t id : chunks.IDs()) {
+            starts.push_back(offset);
+            offset += chunkStore.Size(id);
         }
-        swap(v[i + 1], v[high]);
-        return (i + 1);
     }
 
-    void QuickSort(vector<File>& v, int low, int high) {
-        if (low < high) {
-            int pi = Partition(v, low, high);
-            QuickSort(v, low, pi - 1);
-            QuickSort(v, pi + 1, high);
+    explicit FileReader(string content)
+        : inlineContent(move(content)), isInline(true), nextChunk(0), cachedChunk(SIZE_MAX) {}
+
+    uint64_t Size() const { return isInline ? inlineContent.size() : chunks.Size(); }
+
+    // Next piece of the content in order; false at the end or on a corrupt chunk
+    bool Next(string& out) {
+        out.clear();
+        if (isInline) {
+            if (nextChunk++ > 0 || inlineContent.empty()) return false;
+            out = inlineContent;
+            return true;
         }
+        if (nextChunk >= chunks.IDs().size()) return false;
+        return chunkStore.Read(chunks.IDs()[nextChunk++], out);
     }
 
-    void SortQuickName() {
-        vector<File> v = GetFilesVector();
-        if(!v.empty()) QuickSort(v, 0, v.size()-1);
-        cout << "\n [SORTED BY NAME (QUICK SORT - O(n log n))]\n";
-        for(auto& f : v) f.DisplayRow();
+    // Copies up to len bytes starting at offset; returns how many were copied
+    size_t Read(uint64_t offset, char* buf, size_t len) {
+        if (offset >= Size()) return 0;
+        len = (size_t)min<uint64_t>(len, Size() - offset);
+        if (isInline) {
+            memcpy(buf, inlineContent.data() + offset, len);
+            return len;
+        }
+        size_t index = upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+        size_t copied = 0;
+        while (copied < len) {
+            if (!Load(index)) break;
+            size_t from = (size_t)(offset + copied - starts[index]);
+            size_t n = min(cache.size() - from, len - copied);
+            memcpy(buf + copied, cache.data() + from, n);
+            copied += n;
+            index++;
+        }
+        return copied;
     }
+};
 
-    // 3. Insertion Sort (Size)
-    void SortInsertionSize() {
-        vector<File> v = GetFilesVector();
-        
-        for (size_t i = 1; i < v.size(); i++) {
-            File key = v[i];
-            int j = i - 1;
-            while (j >= 0 && v[j].GetSize() > key.GetSize()) {
-                v[j + 1] = v[j];
-                j--;
-            }
-            v[j + 1] = key;
-        }
-        
-        cout << "\n [SORTED BY SIZE (INSERTION SORT - O(n²))]\n";
-        for(auto& f : v) f.DisplayRow();
+class FileVersion {
+public:
+    string content;     // Delta versions: BinaryDelta against the previous version, compressed with codec
+    ChunkList chunks;   // Keyframes: the full content as chunk-store references
+    string timestamp;
+    int versionNumber;
+    bool isKeyframe;
+    CodecID codec;        // Codec chosen for this version's bytes
+    uint32_t deltaSize;   // Uncompressed size of content
+
+    FileVersion(int v, const string &packedDelta, uint32_t rawDeltaSize, CodecID c)
+        : content(packedDelta), versionNumber(v), isKeyframe(false), codec(c), deltaSize(rawDeltaSize) {
+        timestamp = CurrentTimestamp();
     }
 
-    // 4. Selection Sort (Size)
-    void SortSelectionSize() {
-        vector<File> v = GetFilesVector();
-        
-        for (size_t i = 0; i < v.size() - 1; i++) {
-            int minIdx = i;
-            for (size_t j = i + 1; j < v.size(); j++) {
-                if (v[j].GetSize() < v[minIdx].GetSize()) {
-                    minIdx = j;
-                }
-            }
-            swap(v[i], v[minIdx]);
-        }
-        
-        cout << "\n [SORTED BY SIZE (SELECTION SORT - O(n²))]\n";
-        for(auto& f : v) f.DisplayRow();
+    FileVersion(int v, ChunkList &&keyframe, CodecID c)
+        : chunks(move(keyframe)), versionNumber(v), isKeyframe(true), codec(c), deltaSize(0) {
+        timestamp = CurrentTimestamp();
     }
+};
 
-    // 5. Merge Sort (Size)
-    void Merge(vector<File>& arr, int left, int mid, int right) {
-        int n1 = mid - left + 1;
-        int n2 = right - mid;
-        
-        vector<File> L(n1), R(n2);
-        for (int i = 0; i < n1; i++) L[i] = arr[left + i];
-        for (int j = 0; j < n2; j++) R[j] = arr[mid + 1 + j];
-        
-        int i = 0, j = 0, k = left;
-        while (i < n1 && j < n2) {
-            if (L[i].GetSize() <= R[j].GetSize()) {
-                arr[k] = L[i++];
-            } else {
-                arr[k] = R[j++];
-            }
-            k++;
+/**
+ * @class VersionNode
+ * @brief Node for Singly Linked List storing file versions.
+ *        Never changed once linked, so lists can share their older nodes.
+ */
+class VersionNode {
+public:
+    FileVersion data;
+    shared_ptr<VersionNode> next;
+    
+    VersionNode(const FileVersion& v) : data(v) {}
+    VersionNode(FileVersion&& v) : data(move(v)) {}
+
+    // Frees the older nodes nobody else holds one at a time, so dropping a long
+    // history anywhere (a list, a load that failed halfway) cannot overflow the stack
+    ~VersionNode() {
+        while (next && next.use_count() == 1) {
+            shared_ptr<VersionNode> older = move(next->next);
+            next = move(older);
         }
-        
-        while (i < n1) arr[k++] = L[i++];
-        while (j < n2) arr[k++] = R[j++];
     }
+};
 
-    void MergeSort(vector<File>& arr, int left, int right) {
-        if (left < right) {
-            int mid = left + (right - left) / 2;
-            MergeSort(arr, left, mid);
-            MergeSort(arr, mid + 1, right);
-            Merge(arr, left, mid, right);
+/**
+ * @class VersionLinkedList
+ * @brief Singly Linked List for file version history
+ *
+ * The list is persistent: a new version is pushed in front of the old head
+ * and nodes are never modified afterwards. Copying a list therefore only
+ * shares its head, and a copy that gets a new version grows its own front
+ * while the history behind it stays shared. Shared files rely on this, so
+ * sharing a file costs nothing per version (copy-on-write per node).
+ */
+class VersionLinkedList {
+    friend class DriveSnapshot;
+private:
+    shared_ptr<VersionNode> head;
+    int count;
+    
+    void Clear() {
+        head.reset();  // ~VersionNode frees the rest without recursing
+        count = 0;
+    }
+    
+public:
+    VersionLinkedList() : count(0) {}
+    
+    // Copies share every node
+    VersionLinkedList(const VersionLinkedList& other) : head(other.head), count(other.count) {}
+    
+    VersionLinkedList& operator=(const VersionLinkedList& other) {
+        if (this != &other) {
+            Clear();
+            head = other.head;
+            count = other.count;
         }
+        return *this;
     }
 
-    void SortMergeSize() {
-        vector<File> v = GetFilesVector();
-        if (!v.empty()) MergeSort(v, 0, v.size() - 1);
-        cout << "\n [SORTED BY SIZE (MERGE SORT - O(n log n))]\n";
-        for(auto& f : v) f.DisplayRow();
+    // Move constructor/assignment: hand the nodes over instead of copying them
+    VersionLinkedList(VersionLinkedList&& other) noexcept : head(move(other.head)), count(other.count) {
+        other.count = 0;
     }
 
-    // 6. Heap Sort (Size)
-    void Heapify(vector<File>& arr, int n, int i) {
-        int largest = i;
-        int left = 2 * i + 1;
-        int right = 2 * i + 2;
-        
-        if (left < n && arr[left].GetSize() > arr[largest].GetSize())
-            largest = left;
-        if (right < n && arr[right].GetSize() > arr[largest].GetSize())
-            largest = right;
-        
-        if (largest != i) {
-            swap(arr[i], arr[largest]);
-            Heapify(arr, n, largest);
+    VersionLinkedList& operator=(VersionLinkedList&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            head = move(other.head);
+            count = other.count;
+            other.count = 0;
         }
+        return *this;
     }
-
-    void SortHeapSize() {
-        vector<File> v = GetFilesVector();
-        int n = v.size();
-        
-        // Build max heap
-        for (int i = n / 2 - 1; i >= 0; i--)
-            Heapify(v, n, i);
-        
-        // Extract elements one by one
-        for (int i = n - 1; i > 0; i--) {
-            swap(v[0], v[i]);
-            Heapify(v, i, 0);
-        }
-        
-        cout << "\n [SORTED BY SIZE (HEAP SORT - O(n log n))]\n";
-        for(auto& f : v) f.DisplayRow();
+    
+    ~VersionLinkedList() {
+        Clear();
     }
+    
+    // True if another list holds the newest version too
+    bool IsShared() const { return head && head.use_count() > 1; }
 
-    // 7. Counting Sort (Size) - O(n+k)
-    void SortCountingSize() {
-        vector<File> v = GetFilesVector();
-        if (v.empty()) return;
-        
-        // Find max size
-        int maxSize = v[0].GetSize();
-        for (auto& f : v) {
-            if (f.GetSize() > maxSize) maxSize = f.GetSize();
+    void AddVersion(FileVersion&& v) {
+        shared_ptr<VersionNode> newNode = make_shared<VersionNode>(move(v));
+        newNode->next = move(head);  // Insert at front (LIFO - latest first)
+        head = move(newNode);
+        count++;
+    }
+    
+    int GetCount() const { return count; }
+    
+    void DisplayAll() const {
+        if (!head) {
+            cout << " No versions available.\n";
+            return;
         }
-        
-        // Count array
-        vector<int> count(maxSize + 1, 0);
-        for (auto& f : v) count[f.GetSize()]++;
-        
-        // Cumulative count
-        for (int i = 1; i <= maxSize; i++) count[i] += count[i - 1];
-        
-        // Output array
-        vector<File> output(v.size());
-        for (int i = v.size() - 1; i >= 0; i--) {
-            output[count[v[i].GetSize()] - 1] = v[i];
-            count[v[i].GetSize()]--;
+        const VersionNode* current = head.get();
+        int verNum = count;
+        cout << " --- VERSION HISTORY (Linked List) ---\n";
+        while (current) {
+            cout << " Version " << verNum << " [" << current->data.timestamp << "] "
+                 << (current->data.isKeyframe ? "keyframe" : "delta") << ", "
+                 << CodecRegistry::Get(current->data.codec).Name() << "\n";
+            current = current->next.get();
+            verNum--;
         }
-        
-        cout << "\n [SORTED BY SIZE (COUNTING SORT - O(n+k))]\n";
-        for(auto& f : output) f.DisplayRow();
     }
-
-    // 8. Radix Sort (Name) - O(d*n)
-    void RadixSortNames(vector<File>& arr) {
-        if (arr.empty()) return;
-        
-        // Get max length
-        int maxLen = 0;
-        for (auto& f : arr) {
-            int len = f.GetName().length();
-            if (len > maxLen) maxLen = len;
+    
+    /**
+     * @brief  Versions needed to rebuild versionNum: its nearest keyframe
+     *         followed by every delta up to it, oldest first.
+     * @return Empty if versionNum does not exist.
+     */
+    vector<const FileVersion*> GetChain(int versionNum) const {
+        vector<const FileVersion*> chain;
+        if (versionNum < 1 || versionNum > count) return chain;
+
+        const VersionNode* current = head.get();
+        int pos = count;
+        while (current && pos != versionNum) {
+            current = current->next.get();
+            pos--;
         }
-        
-        // Sort by each character position (right to left)
-        for (int pos = maxLen - 1; pos >= 0; pos--) {
-            vector<File> output(arr.size());
-            vector<int> count(256, 0);  // ASCII characters
-            
-            // Count occurrences
-            for (auto& f : arr) {
-                char ch = (pos < f.GetName().length()) ? tolower(f.GetName()[pos]) : 0;
-                count[ch]++;
-            }
-            
-            // Cumulative count
-            for (int i = 1; i < 256; i++) count[i] += count[i - 1];
-            
-            // Build output
-            for (int i = arr.size() - 1; i >= 0; i--) {
-                char ch = (pos < arr[i].GetName().length()) ? tolower(arr[i].GetName()[pos]) : 0;
-                output[count[ch] - 1] = arr[i];
-                count[ch]--;
-            }
-            
-            arr = output;
+        for (; current; current = current->next.get()) {
+            chain.push_back(&current->data);
+            if (current->data.isKeyframe) break;
         }
+        reverse(chain.begin(), chain.end());
+        return chain;
     }
-
-    void SortRadixName() {
-        vector<File> v = GetFilesVector();
-        if (!v.empty()) RadixSortNames(v);
-        cout << "\n [SORTED BY NAME (RADIX SORT - O(d*n))]\n";
-        for(auto& f : v) f.DisplayRow();
-    }
+    
 };
 
-class Folder {
+/**
+ * @class File
+ * @brief Represents a single file entity with version control and metadata.
+ */
+class File {
+    friend class DriveSnapshot;
 private:
+    int id;
     string name;
+    string type;
     string owner;
-    int id;
-    int fileIDCounter;
-    
-    HashTableFiles files;
-    FileStack deletedFiles;
-    FileQueue recentFiles;
-    FileMaxHeap starredFiles;
-    FileDoubleLinkedList fileNavigator;  // For file browsing
+    int64_t sizeBytes;
+    int priority; // 1-10, for Heap
+    VersionLinkedList versions;  // Changed from vector to Linked List
+    vector<string> tags;
+        
 
 public:
-    Folder() : id(0), fileIDCounter(1) {}
-    
-    // Copy constructor - CRITICAL: Ensures all members are properly copied
-    Folder(const Folder& other) 
-        : name(other.name), owner(other.owner), id(other.id), 
-          fileIDCounter(other.fileIDCounter),
-          files(other.files),  // HashTableFiles now has proper copy semantics
-          deletedFiles(other.deletedFiles),  // FileStack uses array, safe
-          recentFiles(other.recentFiles),  // FileQueue uses array, safe
-          starredFiles(other.starredFiles),  // FileMaxHeap uses vector, safe
-          fileNavigator(other.fileNavigator)  // FileDoubleLinkedList now has copy semantics
-    {}
-    
-    // Copy assignment operator - CRITICAL: Ensures safe assignment
-    Folder& operator=(const Folder& other) {
-        if (this != &other) {
-            name = other.name;
-            owner = other.owner;
-            id = other.id;
-            fileIDCounter = other.fileIDCounter;
-            files = other.files;
-            deletedFiles = other.deletedFiles;
-            recentFiles = other.recentFiles;
-            starredFiles = other.starredFiles;
-            fileNavigator = other.fileNavigator;
-        }
-        return *this;
-    }
+    File() : id(0), sizeBytes(0), priority(0) {} 
 
-    void SetValues(const string &n, int i, const string &own) {
-        name = n; id = i; owner = own;
-    }
-    
-    string GetName() const { return name; }
-    int GetID() const { return id; }
-    int GetFileIDCounter() const { return fileIDCounter; }
+    // Copies share chunks but duplicate the version list; moves hand everything over
+    File(const File&) = default;
+    File(File&&) noexcept = default;
+    File& operator=(const File&) = default;
+    File& operator=(File&&) noexcept = default;
 
-    void CreateFile() {
-        PrintHeader("CREATE NEW FILE");
-        string fname = InputString(" Enter file name: ");
-        string type = InputString(" Enter file type (txt/doc/cpp): ");
-        string content = InputString(" Enter content: ");
-        int prio = InputInt(" Enter Priority (1-10): ", 1, 10);
+    void SetValues(int id_, const string &name_, const string &type_, const string &owner_, const string &content_, int prio = 1) {
+        id = id_;
+        name = name_;
+        type = type_;
+        owner = owner_;
+        priority = prio;
+        sizeBytes = content_.size();
+        AddVersion(content_);
+    }
+
+    // Same as above for content that was streamed in through a FileWriter
+    void SetValues(int id_, const string &name_, const string &type_, const string &owner_, ChunkList &&content_, CodecID codec, int prio = 1) {
+        id = id_;
+        name = name_;
+        type = type_;
+        owner = owner_;
+        priority = prio;
+        AddVersion(move(content_), codec);
+    }
+
+    // Stores a delta when it is smaller than the content, otherwise a keyframe.
+    // Either way the codec is picked by sampling the bytes actually stored.
+    void AddVersion(const string &rawContent) {
+        int nextVer = versions.GetCount() + 1;
+        bool small = (uint64_t)sizeBytes <= FILE_DELTA_MAX_SIZE && rawContent.size() <= FILE_DELTA_MAX_SIZE;
+        if (small && (nextVer - 1) % VERSION_KEYFRAME_INTERVAL != 0) {
+            string delta = BinaryDelta::Encode(GetContent(), rawContent);
+            string packed;
+            CodecID codec = CodecRegistry::Compress(CodecRegistry::Choose(delta.data(), delta.size()),
+                                                    delta.data(), delta.size(), packed);
+            if (packed.size() < rawContent.size()) {
+                versions.AddVersion(FileVersion(nextVer, packed, delta.size(), codec));
+                sizeBytes = rawContent.size();
+                return;
+            }
+        }
+        CodecID codec = CodecRegistry::Choose(rawContent.data(), rawContent.size());
+        versions.AddVersion(FileVersion(nextVer, ChunkList(rawContent, codec), codec));
+        sizeBytes = rawContent.size();
+    }
+
+    // Streamed content is always stored as a keyframe; it is never held in memory whole
+    void AddVersion(ChunkList &&content, CodecID codec) {
+        sizeBytes = content.Size();
+        versions.AddVersion(FileVersion(versions.GetCount() + 1, move(content), codec));
+    }
+
+    // Rebuilds a version from its keyframe, replaying at most VERSION_KEYFRAME_INTERVAL deltas
+    string GetVersionContent(int versionNum) const {
+        vector<const FileVersion*> chain = versions.GetChain(versionNum);
+        if (chain.empty()) return "";
+        string content = chain[0]->chunks.Read();
+        string delta, next;
+        for (size_t i = 1; i < chain.size(); i++) {
+            delta.clear();
+            if (!CodecRegistry::Decompress(chain[i]->codec, chain[i]->content, chain[i]->deltaSize, delta)) return "";
+            if (!BinaryDelta::Apply(content, delta, next)) return "";
+            content.swap(next);
+        }
+        return content;
+    }
+
+    string GetContent() const {
+        return GetVersionContent(versions.GetCount());
+    }
+
+    /**
+     * @brief  Streams a version without rebuilding it in memory (keyframes),
+     *         or from its rebuilt content (deltas, which are always small).
+     * @return A reader of size 0 if versionNum does not exist.
+     */
+    FileReader OpenVersion(int versionNum) const {
+        vector<const FileVersion*> chain = versions.GetChain(versionNum);
+        if (chain.size() == 1) return FileReader(chain[0]->chunks);
+        return FileReader(GetVersionContent(versionNum));
+    }
+
+    // The first FILE_PREVIEW_BYTES of a version, for display
+    string GetPreview(int versionNum) const {
+        FileReader reader = OpenVersion(versionNum);
+        string preview(min<uint64_t>(reader.Size(), FILE_PREVIEW_BYTES), '\0');
+        preview.resize(reader.Read(0, &preview[0], preview.size()));
+        if (reader.Size() > preview.size()) preview += " ... (" + to_string(reader.Size() - preview.size()) + " more bytes)";
+        return preview;
+    }
+    
+    void DisplayVersionHistory() const {
+        versions.DisplayAll();
+    }
+    
+    int GetVersionCount() const {
+        return versions.GetCount();
+    }
+
+    void DisplayDetailed() const {
+        PrintLine('.');
+        cout << " FILE DETAILS\n";
+        cout << " ID:       " << id << "\n";
+        cout << " Name:     " << name << "." << type << "\n";
+        cout << " Owner:    " << owner << "\n";
+        cout << " Priority: " << priority << "/10\n";
+        cout << " Size:     " << sizeBytes << " bytes\n";
+        cout << " Versions: " << versions.GetCount() << "\n";
+        cout << " Content:  " << GetPreview(versions.GetCount()) << "\n";
+        PrintLine('.');
+    }
+
+    void DisplayRow() const {
+        cout << " " << setw(5) << id << " | " << setw(15) << name << " | " << setw(5) << type << " | " << setw(5) << sizeBytes << "B | Prio: " << priority << endl;
+    }
+
+    int GetID() const { return id; }
+    void SetID(int newID) { id = newID; } 
+    const string& GetName() const { return name; }
+    int64_t GetSize() const { return sizeBytes; }
+    int GetPriority() const { return priority; }
+    void SetPriority(int p) { priority = p; }
+};
+
+/**
+ * @class FileNode
+ * @brief Node for Double Linked List for file navigation
+ */
+class FileNode {
+public:
+    File* data;   // Handle into the folder's table, not a copy
+    FileNode* prev;
+    FileNode* next;
+    
+    FileNode(File* f) : data(f), prev(nullptr), next(nullptr) {}
+};
+
+/**
+ * @class FileDoubleLinkedList
+ * @brief Double Linked List for sequential file browsing.
+ *        Nodes hold handles, so the list is only valid while the files stay put.
+ */
+class FileDoubleLinkedList {
+private:
+    FileNode* head;
+    FileNode* tail;
+    FileNode* current;  // Current position for navigation
+    
+    // Helper to copy nodes
+    void CopyNodes(const FileDoubleLinkedList& other) {
+        if (!other.head) {
+            head = tail = current = nullptr;
+            return;
+        }
         
-        File f;
-        f.SetValues(fileIDCounter, fname, type, owner, content, prio);
-        files.Insert(f);
+        // Copy first node
+        head = new FileNode(other.head->data);
+        FileNode* otherCurrent = other.head->next;
+        FileNode* thisCurrent = head;
+        current = head;  // Set current to head initially
+        
+        // Copy remaining nodes
+        while (otherCurrent) {
+            thisCurrent->next = new FileNode(otherCurrent->data);
+            thisCurrent->next->prev = thisCurrent;
+            thisCurrent = thisCurrent->next;
+            otherCurrent = otherCurrent->next;
+        }
+        
+        tail = thisCurrent;
+    }
+    
+public:
+    FileDoubleLinkedList() : head(nullptr), tail(nullptr), current(nullptr) {}
+    
+    // Copy constructor
+    FileDoubleLinkedList(const FileDoubleLinkedList& other) : head(nullptr), tail(nullptr), current(nullptr) {
+        CopyNodes(other);
+    }
+    
+    // Copy assignment operator
+    FileDoubleLinkedList& operator=(const FileDoubleLinkedList& other) {
+        if (this != &other) {
+            Clear();
+            CopyNodes(other);
+        }
+        return *this;
+    }
+
+    FileDoubleLinkedList(FileDoubleLinkedList&& other) noexcept
+        : head(other.head), tail(other.tail), current(other.current) {
+        other.head = other.tail = other.current = nullptr;
+    }
+
+    FileDoubleLinkedList& operator=(FileDoubleLinkedList&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            head = other.head;
+            tail = other.tail;
+            current = other.current;
+            other.head = other.tail = other.current = nullptr;
+        }
+        return *this;
+    }
+    
+    ~FileDoubleLinkedList() {
+        Clear();
+    }
+    
+    void AddFile(File* f) {
+        FileNode* newNode = new FileNode(f);
+        if (!head) {
+            head = tail = current = newNode;
+        } else {
+            tail->next = newNode;
+            newNode->prev = tail;
+            tail = newNode;
+        }
+    }
+    
+    void Clear() {
+        FileNode* temp = head;
+        while (temp) {
+            FileNode* next = temp->next;
+            delete temp;
+            temp = next;
+        }
+        head = tail = current = nullptr;
+    }
+    
+    void BuildFromVector(const vector<File*>& files) {
+        Clear();
+        for (File* f : files) {
+            AddFile(f);
+        }
+        current = head;  // Reset to beginning
+    }
+    
+    File* GetCurrent() { 
+        return current ? current->data : nullptr; 
+    }
+    
+    File* GetNext() { 
+        if (current && current->next) {
+            current = current->next;
+            return current->data;
+        }
+        return nullptr;
+    }
+    
+    File* GetPrev() {
+        if (current && current->prev) {
+            current = current->prev;
+            return current->data;
+        }
+        return nullptr;
+    }
+    
+    void Reset() { current = head; }
+    
+    bool HasNext() const { return current && current->next != nullptr; }
+    bool HasPrev() const { return current && current->prev != nullptr; }
+};
+
+/**
+ * @class NotificationNode
+ * @brief Node for Circular Linked List storing notifications
+ */
+class NotificationNode {
+public:
+    string message;
+    NotificationNode* next;
+    
+    NotificationNode(const string& msg) : message(msg), next(nullptr) {}
+};
+
+/**
+ * @class CircularNotificationQueue
+ * @brief Circular Linked List for notification management
+ */
+class CircularNotificationQueue {
+    friend class DriveSnapshot;
+private:
+    NotificationNode* tail;  // Points to last node (tail->next = head)
+    int count;
+    
+public:
+    CircularNotificationQueue() : tail(nullptr), count(0) {}
+    
+    ~CircularNotificationQueue() {
+        if (!tail) return;
+        
+        NotificationNode* current = tail->next;  // Start from head
+        NotificationNode* start = current;
+        
+        if (current) {
+            do {
+                NotificationNode* temp = current;
+                current = current->next;
+                delete temp;
+            } while (current != start);
+        }
+    }
+    
+    void AddNotification(const string& msg) {
+        NotificationNode* newNode = new NotificationNode(msg);
+        if (!tail) {
+            tail = newNode;
+            tail->next = tail;  // Points to itself (circular)
+        } else {
+            newNode->next = tail->next;  // New node points to head
+            tail->next = newNode;        // Old tail points to new node
+            tail = newNode;              // Update tail
+        }
+        count++;
+    }
+    
+    void DisplayAll() {
+        if (!tail) { 
+            cout << " No notifications.\n"; 
+            return; 
+        }
+        
+        NotificationNode* current = tail->next;  // Start from head
+        NotificationNode* start = current;
+        int idx = 1;
         
-        if (prio >= 8) starredFiles.Insert(f); // Auto-star high priority
+        cout << " --- NOTIFICATIONS (Circular Linked List) ---\n";
+        do {
+            cout << " [" << idx++ << "] " << current->message << endl;
+            current = current->next;
+        } while (current != start);  // Until we circle back
+    }
+    
+    int GetCount() const { return count; }
+    
+    void Clear() {
+        if (!tail) return;
+        
+        NotificationNode* current = tail->next;
+        NotificationNode* start = current;
+        
+        if (current) {
+            do {
+                NotificationNode* temp = current;
+                current = current->next;
+                delete temp;
+            } while (current != start);
+        }
+        
+        tail = nullptr;
+        count = 0;
+    }
+};
+
+/**
+ * @class FileStack
+ * @brief Implements LIFO structure for Deleted Files (Trash Bin).
+ *
+ * A ring buffer of owned file handles kept in deletion order. Recovery pops
+ * the newest end; overflow and expiry drop from the oldest end, so every
+ * operation is O(1) per file. The buffer is only allocated once something is
+ * deleted and doubles up to the owner's trash capacity.
+ */
+class FileStack { 
+    friend class DriveSnapshot;
+    struct Entry {
+        File* file;
+        int64_t deletedAt;
+    };
+    vector<Entry> ring;
+    size_t head;      // Oldest entry
+    size_t count;
+    bool timerArmed;  // An expiry timer for this trash is waiting in the owner's wheel
+
+    Entry& At(size_t i) { return ring[(head + i) % ring.size()]; }  // i-th oldest
+    const Entry& At(size_t i) const { return ring[(head + i) % ring.size()]; }
+
+    void DropOldest() {
+        delete ring[head].file;
+        head = (head + 1) % ring.size();
+        count--;
+    }
+
+    void Grow(size_t limit) {
+        vector<Entry> bigger(min(max<size_t>(ring.size() * 2, 4), limit));
+        for (size_t i = 0; i < count; i++) bigger[i] = At(i);
+        ring.swap(bigger);
+        head = 0;
+    }
+
+    void ReleaseIfEmpty() {
+        if (count == 0) {
+            vector<Entry>().swap(ring);
+            head = 0;
+        }
+    }
+
+public:
+    FileStack() : head(0), count(0), timerArmed(false) {}
+
+    // A copy owns its own files and has no timer until its owner arms one
+    FileStack(const FileStack& other) : ring(other.count), head(0), count(other.count), timerArmed(false) {
+        for (size_t i = 0; i < count; i++) {
+            ring[i] = {new File(*other.At(i).file), other.At(i).deletedAt};
+        }
+    }
+
+    FileStack& operator=(const FileStack& other) {
+        if (this != &other) {
+            FileStack copy(other);
+            *this = move(copy);
+        }
+        return *this;
+    }
+
+    FileStack(FileStack&& other) noexcept
+        : ring(move(other.ring)), head(other.head), count(other.count), timerArmed(other.timerArmed) {
+        other.ring.clear();
+        other.head = other.count = 0;
+        other.timerArmed = false;
+    }
+
+    FileStack& operator=(FileStack&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            ring.swap(other.ring);
+            swap(head, other.head);
+            swap(count, other.count);
+            swap(timerArmed, other.timerArmed);
+        }
+        return *this;
+    }
+
+    ~FileStack() { Clear(); }
+
+    /**
+     * @brief  Moves a deleted file into the trash, dropping the oldest if it is full.
+     * @return true if an older file had to be dropped.
+     */
+    bool Push(File&& f, int64_t deletedAt, size_t limit = DEFAULT_TRASH_CAPACITY) {
+        bool dropped = false;
+        while (count > 0 && count >= limit) {
+            DropOldest();
+            dropped = true;
+        }
+        if (count == ring.size()) Grow(limit);
+        ring[(head + count) % ring.size()] = {new File(move(f)), deletedAt};
+        count++;
+        if (dropped) cout << " [WARN] Trash bin full. Oldest deleted file overwritten.\n";
+        return dropped;
+    }
+
+    File Pop() { 
+        if(IsEmpty()) return File();
+        Entry& e = At(count - 1);
+        File f = move(*e.file);
+        delete e.file;
+        count--;
+        return f;
+    }
+
+    bool IsEmpty() const { return count == 0; }
+    size_t Size() const { return count; }
+    int64_t OldestDeletedAt() const { return At(0).deletedAt; }
+    bool TimerArmed() const { return timerArmed; }
+    void SetTimerArmed(bool armed) { timerArmed = armed; }
+
+    /**
+     * @brief  Drops every file deleted at or before cutoff.
+     * @return How many files were dropped. Stops at the first newer file, so
+     *         the cost is the number expired.
+     */
+    size_t PurgeExpired(int64_t cutoff) {
+        size_t purged = 0;
+        while (count > 0 && At(0).deletedAt <= cutoff) {
+            DropOldest();
+            purged++;
+        }
+        ReleaseIfEmpty();
+        return purged;
+    }
+
+    // Drops the oldest files until at most limit remain
+    size_t Trim(size_t limit) {
+        size_t dropped = 0;
+        while (count > limit) {
+            DropOldest();
+            dropped++;
+        }
+        ReleaseIfEmpty();
+        return dropped;
+    }
+
+    void Clear() {
+        while (count > 0) DropOldest();
+        ReleaseIfEmpty();
+    }
+    
+    void EmptyTrash() {
+        Clear();
+        cout << " Trash bin emptied.\n";
+    }
+
+    // Visits the trashed files oldest first
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        for (size_t i = 0; i < count; i++) fn(*At(i).file, At(i).deletedAt);
+    }
+
+    void Display(int64_t retention = DEFAULT_TRASH_RETENTION) const {
+        if(IsEmpty()) { cout << " (Trash is empty)\n"; return; }
+        for (size_t i = count; i-- > 0;) {
+            const Entry& e = At(i);
+            cout << " [" << i+1 << "] " << e.file->GetName() << " (ID: " << e.file->GetID()
+                 << ", expires " << FormatTimestamp(e.deletedAt + retention) << ")\n";
+        }
+    }
+};
+
+/**
+ * @class TrashPolicy
+ * @brief Per-user trash limits plus the timing wheel that expires old trash.
+ *
+ * Every folder with something in its trash has one timer, due when its oldest
+ * file outlives the retention period. Timers hash into WHEEL_SLOTS buckets
+ * that each cover retention/WHEEL_SLOTS seconds, so Advance() only looks at
+ * the buckets the clock has passed and the timers in them; folders with an
+ * empty trash never appear in the wheel.
+ */
+class TrashPolicy {
+public:
+    static const int WHEEL_SLOTS = 256;
+
+private:
+    struct Timer {
+        int folderID;
+        int64_t tick;
+    };
+    int capacity;
+    int64_t retention;
+    int64_t tickSeconds;
+    int64_t lastTick;             // Every tick up to this one has been processed
+    vector<vector<Timer>> wheel;  // Allocated by the first Schedule()
+    size_t pending;
+
+public:
+    TrashPolicy() : pending(0) { Reset(DEFAULT_TRASH_CAPACITY, DEFAULT_TRASH_RETENTION, time(nullptr)); }
+
+    int Capacity() const { return capacity; }
+    int64_t Retention() const { return retention; }
+    size_t Pending() const { return pending; }
+
+    static bool ValidLimits(int cap, int64_t keep) {
+        return cap >= 1 && cap <= MAX_TRASH_CAPACITY && keep >= 1;
+    }
+
+    // Applies new limits and drops every timer; the owner re-arms its folders afterwards
+    void Reset(int cap, int64_t keep, int64_t now) {
+        capacity = cap;
+        retention = keep;
+        tickSeconds = max<int64_t>(1, (keep + WHEEL_SLOTS - 1) / WHEEL_SLOTS);
+        lastTick = now / tickSeconds - 1;  // Timers already overdue fire on the first Advance()
+        vector<vector<Timer>>().swap(wheel);
+        pending = 0;
+    }
+
+    void Schedule(int folderID, int64_t dueAt) {
+        if (wheel.empty()) wheel.resize(WHEEL_SLOTS);
+        int64_t tick = max((dueAt + tickSeconds - 1) / tickSeconds, lastTick + 1);  // Overdue timers fire next
+        wheel[tick % WHEEL_SLOTS].push_back({folderID, tick});
+        pending++;
+    }
+
+    /**
+     * @brief  Fires every timer due by now; fire(folderID) may schedule new timers.
+     * @return The sum of what fire() returned.
+     */
+    template <typename Fire>
+    size_t Advance(int64_t now, Fire fire) {
+        int64_t nowTick = now / tickSeconds;
+        if (nowTick <= lastTick) return 0;
+        int64_t from = max(lastTick + 1, nowTick - WHEEL_SLOTS + 1);  // One lap covers a long gap
+        lastTick = nowTick;  // Timers scheduled while firing land in the future
+        size_t total = 0;
+        for (int64_t t = from; t <= nowTick && pending > 0; t++) {
+            vector<Timer>& slot = wheel[t % WHEEL_SLOTS];
+            for (size_t i = 0; i < slot.size();) {
+                if (slot[i].tick > nowTick) { i++; continue; }  // A later lap
+                int folderID = slot[i].folderID;
+                slot[i] = slot.back();
+                slot.pop_back();
+                pending--;
+                total += fire(folderID);
+            }
+        }
+        return total;
+    }
+};
+
+/**
+ * @class RecentFiles
+ * @brief LRU list for Recent Files history.
+ *
+ * Keeps only file IDs and access times. A hash map from ID to slot finds an
+ * entry in O(1); slots are linked newest to oldest, so re-opening a file moves
+ * it to the front instead of adding a duplicate, and once the list is full the
+ * least recently opened file is evicted.
+ */
+class RecentFiles {
+    friend class DriveSnapshot;
+public:
+    struct Access {
+        int fileID;
+        int64_t accessedAt;  // Microseconds since the epoch
+    };
+
+private:
+    struct Node {
+        Access access;
+        int prev, next;  // Slots; -1 ends the list
+    };
+    vector<Node> nodes;
+    unordered_map<int, int> slotOf;  // File ID -> slot
+    int newest, oldest;
+    int freeSlot;  // Head of the slots left by Remove(), chained through next
+
+    void Unlink(int s) {
+        Node& n = nodes[s];
+        if (n.prev != -1) nodes[n.prev].next = n.next; else newest = n.next;
+        if (n.next != -1) nodes[n.next].prev = n.prev; else oldest = n.prev;
+    }
+
+    void LinkFront(int s) {
+        nodes[s].prev = -1;
+        nodes[s].next = newest;
+        if (newest != -1) nodes[newest].prev = s; else oldest = s;
+        newest = s;
+    }
+
+public:
+    RecentFiles() : newest(-1), oldest(-1), freeSlot(-1) {}
+
+    // Records that fileID was opened at accessedAt and moves it to the front
+    void Touch(int fileID, int64_t accessedAt) {
+        auto it = slotOf.find(fileID);
+        int s;
+        if (it != slotOf.end()) {
+            s = it->second;
+            Unlink(s);
+        } else if (freeSlot != -1) {
+            s = freeSlot;
+            freeSlot = nodes[s].next;
+            slotOf[fileID] = s;
+        } else if (nodes.size() < (size_t)MAX_RECENT_FILES) {
+            s = nodes.size();
+            nodes.push_back(Node());
+            slotOf[fileID] = s;
+        } else {
+            s = oldest;  // Evict the least recently opened file
+            Unlink(s);
+            slotOf.erase(nodes[s].access.fileID);
+            slotOf[fileID] = s;
+        }
+        nodes[s].access = {fileID, accessedAt};
+        LinkFront(s);
+    }
+
+    // Forgets a file that no longer exists in the folder
+    void Remove(int fileID) {
+        auto it = slotOf.find(fileID);
+        if (it == slotOf.end()) return;
+        int s = it->second;
+        slotOf.erase(it);
+        Unlink(s);
+        nodes[s].next = freeSlot;
+        freeSlot = s;
+    }
+
+    size_t Size() const { return slotOf.size(); }
+
+    // Slot cursor, newest first: First(), then After(slot) until -1
+    int First() const { return newest; }
+    int After(int slot) const { return nodes[slot].next; }
+    const Access& At(int slot) const { return nodes[slot].access; }
+
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        for (int s = newest; s != -1; s = nodes[s].next) fn(nodes[s].access);
+    }
+};
+
+/**
+ * @class FileMaxHeap
+ * @brief Manages "Starred" or High Priority files.
+ *
+ * An indexed max-heap of {file ID, priority}: a hash map from ID to heap
+ * position lets a priority change or removal re-heapify in O(log n). Only
+ * IDs are kept, so entries cannot go stale when a file gets a new version;
+ * the folder resolves them through its hash table.
+ */
+class FileMaxHeap {
+    friend class DriveSnapshot;
+public:
+    struct Entry {
+        int fileID;
+        int priority;
+    };
+
+private:
+    vector<Entry> heap;
+    unordered_map<int, int> position;  // File ID -> index in heap
+
+    static int Parent(int i) { return (i - 1) / 2; }
+    static int Left(int i) { return (2 * i + 1); }
+    static int Right(int i) { return (2 * i + 2); }
+
+    // Higher priority first; equal priorities by lower ID so the order is stable
+    static bool Above(const Entry& a, const Entry& b) {
+        return a.priority != b.priority ? a.priority > b.priority : a.fileID < b.fileID;
+    }
+
+    void Swap(int i, int j) {
+        swap(heap[i], heap[j]);
+        position[heap[i].fileID] = i;
+        position[heap[j].fileID] = j;
+    }
+
+    void HeapifyDown(int i) {
+        int n = heap.size();
+        while (true) {
+            int l = Left(i);
+            int r = Right(i);
+            int largest = i;
+            if (l < n && Above(heap[l], heap[largest])) largest = l;
+            if (r < n && Above(heap[r], heap[largest])) largest = r;
+            if (largest == i) return;
+            Swap(i, largest);
+            i = largest;
+        }
+    }
+
+    void HeapifyUp(int i) {
+        while (i && Above(heap[i], heap[Parent(i)])) {
+            Swap(i, Parent(i));
+            i = Parent(i);
+        }
+    }
+
+public:
+    // Adds the file, or moves it to its new place if it is already starred
+    void Insert(int fileID, int priority) {
+        auto it = position.find(fileID);
+        if (it == position.end()) {
+            position[fileID] = heap.size();
+            heap.push_back({fileID, priority});
+            HeapifyUp(heap.size() - 1);
+            return;
+        }
+        int i = it->second;
+        heap[i].priority = priority;
+        HeapifyUp(i);
+        HeapifyDown(position[fileID]);
+    }
+
+    bool Remove(int fileID) {
+        auto it = position.find(fileID);
+        if (it == position.end()) return false;
+        int i = it->second;
+        position.erase(it);
+        int last = heap.size() - 1;
+        if (i != last) {
+            heap[i] = heap[last];
+            position[heap[i].fileID] = i;
+        }
+        heap.pop_back();
+        if (i < (int)heap.size()) {
+            HeapifyUp(i);
+            HeapifyDown(position[heap[i].fileID]);
+        }
+        return true;
+    }
+
+    bool Contains(int fileID) const { return position.count(fileID) > 0; }
+    size_t Size() const { return heap.size(); }
+
+    /**
+     * @brief Calls fn(entry) for the k highest-priority files, best first.
+     *
+     * The heap is left untouched: a small frontier heap of positions starts
+     * at the root and each emitted node adds its two children, so the cost
+     * is O(k log k) whatever the number of starred files.
+     */
+    template <typename Fn>
+    void TopK(size_t k, Fn fn) const {
+        auto below = [this](int a, int b) { return Above(heap[b], heap[a]); };
+        priority_queue<int, vector<int>, decltype(below)> frontier(below);
+        if (!heap.empty()) frontier.push(0);
+        for (size_t emitted = 0; emitted < k && !frontier.empty(); emitted++) {
+            int i = frontier.top();
+            frontier.pop();
+            fn(heap[i]);
+            if (Left(i) < (int)heap.size()) frontier.push(Left(i));
+            if (Right(i) < (int)heap.size()) frontier.push(Right(i));
+        }
+    }
+};
+
+/**
+ * @class SwissTable
+ * @brief Open-addressing map from file ID to File* in the Swiss-table layout.
+ *
+ * Every slot has a control byte: EMPTY, DELETED, or the low 7 bits of the
+ * key's hash. Probing loads 16 control bytes at once and compares them all
+ * against the hash byte with one SSE2 instruction (a scalar loop without
+ * SSE2), so only slots whose hash byte matches are ever dereferenced. The
+ * first 15 control bytes are mirrored after the end so a group read never
+ * wraps. Deletion writes EMPTY whenever no probe can have passed over the
+ * slot, so DELETED markers are only left inside runs of 16+ full slots.
+ * The table never owns the files; HashTableFiles does.
+ */
+class SwissTable {
+public:
+    static const size_t GROUP = 16;
+
+private:
+    static const uint8_t EMPTY = 0x80;
+    static const uint8_t DELETED = 0xFE;
+
+    uint8_t* ctrl;      // capacity + GROUP - 1 bytes
+    File** slots;
+    size_t capacity;    // Power of two, at least GROUP (0 = no table)
+    size_t size;
+    size_t tombstones;
+
+    static uint64_t Hash(int id) {
+        uint64_t z = (uint64_t)(uint32_t)id + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Bit i set if control byte i of the group equals b
+    static uint32_t Match(const uint8_t* group, uint8_t b) {
+#ifdef __SSE2__
+        __m128i g = _mm_loadu_si128((const __m128i*)group);
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)b)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; i++) mask |= (uint32_t)(group[i] == b) << i;
+        return mask;
+#endif
+    }
+
+    // Bit i set if slot i is EMPTY or DELETED (the only bytes with the high bit set)
+    static uint32_t MatchFree(const uint8_t* group) {
+#ifdef __SSE2__
+        return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; i++) mask |= (uint32_t)(group[i] >> 7) << i;
+        return mask;
+#endif
+    }
+
+    static int LowestBit(uint32_t mask) {
+        int i = 0;
+        while (!(mask & 1)) { mask >>= 1; i++; }
+        return i;
+    }
+
+    void SetCtrl(size_t i, uint8_t v) {
+        ctrl[i] = v;
+        if (i < GROUP - 1) ctrl[capacity + i] = v;  // Mirror
+    }
+
+    void Free() {
+        delete[] ctrl;
+        delete[] slots;
+        ctrl = nullptr;
+        slots = nullptr;
+        capacity = size = tombstones = 0;
+    }
+
+public:
+    explicit SwissTable(size_t cap = 0) : ctrl(nullptr), slots(nullptr), capacity(0), size(0), tombstones(0) {
+        if (cap == 0) return;
+        capacity = GROUP;
+        while (capacity < cap) capacity *= 2;
+        ctrl = new uint8_t[capacity + GROUP - 1];
+        memset(ctrl, EMPTY, capacity + GROUP - 1);
+        slots = new File*[capacity];
+    }
+
+    SwissTable(const SwissTable&) = delete;
+    SwissTable& operator=(const SwissTable&) = delete;
+
+    SwissTable(SwissTable&& other) noexcept
+        : ctrl(other.ctrl), slots(other.slots), capacity(other.capacity), size(other.size), tombstones(other.tombstones) {
+        other.ctrl = nullptr;
+        other.slots = nullptr;
+        other.capacity = other.size = other.tombstones = 0;
+    }
+
+    SwissTable& operator=(SwissTable&& other) noexcept {
+        if (this != &other) {
+            Free();
+            swap(ctrl, other.ctrl);
+            swap(slots, other.slots);
+            swap(capacity, other.capacity);
+            swap(size, other.size);
+            swap(tombstones, other.tombstones);
+        }
+        return *this;
+    }
+
+    ~SwissTable() { Free(); }
+
+    size_t Capacity() const { return capacity; }
+    size_t Size() const { return size; }
+    size_t Tombstones() const { return tombstones; }
+
+    // Inserts are allowed while full + deleted slots stay under 7/8
+    bool HasRoom() const { return capacity && (size + tombstones + 1) * 8 <= capacity * 7; }
+
+    // Slot index holding id, or -1
+    long Find(int id) const {
+        if (!capacity) return -1;
+        uint64_t h = Hash(id);
+        uint8_t tag = h & 0x7F;
+        size_t mask = capacity - 1;
+        size_t pos = (h >> 7) & mask;
+        for (size_t step = 0;; ) {
+            const uint8_t* group = ctrl + pos;
+            for (uint32_t m = Match(group, tag); m; m &= m - 1) {
+                size_t i = (pos + LowestBit(m)) & mask;
+                if (slots[i]->GetID() == id) return (long)i;
+            }
+            if (Match(group, EMPTY)) return -1;
+            step += GROUP;
+            if (step > capacity) return -1;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // Caller checks HasRoom() and that the ID is not present yet
+    void Insert(File* f) {
+        uint64_t h = Hash(f->GetID());
+        size_t mask = capacity - 1;
+        size_t pos = (h >> 7) & mask;
+        for (size_t step = 0;; ) {
+            uint32_t m = MatchFree(ctrl + pos);
+            if (m) {
+                size_t i = (pos + LowestBit(m)) & mask;
+                if (ctrl[i] == DELETED) tombstones--;
+                SetCtrl(i, h & 0x7F);
+                slots[i] = f;
+                size++;
+                return;
+            }
+            step += GROUP;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    File* At(size_t i) const { return (ctrl[i] & 0x80) ? nullptr : slots[i]; }
+
+    void EraseAt(size_t i) {
+        size_t mask = capacity - 1;
+        uint32_t emptyAfter = Match(ctrl + i, EMPTY);
+        uint32_t emptyBefore = Match(ctrl + ((i - GROUP) & mask), EMPTY);
+        // The run of full slots through i is shorter than a group, so every
+        // group window over i holds an EMPTY and stops probes: safe to free
+        int fullAfter = emptyAfter ? LowestBit(emptyAfter) : (int)GROUP;
+        int fullBefore = 0;
+        while (fullBefore < (int)GROUP && !(emptyBefore & (1u << (GROUP - 1 - fullBefore)))) fullBefore++;
+        if (emptyAfter && emptyBefore && fullAfter + fullBefore < (int)GROUP) {
+            SetCtrl(i, EMPTY);
+        } else {
+            SetCtrl(i, DELETED);
+            tombstones++;
+        }
+        size--;
+    }
+
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        for (size_t i = 0; i < capacity; i++) {
+            if (!(ctrl[i] & 0x80)) fn(*slots[i]);
+        }
+    }
+};
+
+/**
+ * @class ParallelSort
+ * @brief Multi-threaded sorts over compact (key, handle) pairs.
+ *
+ * Folder sorts switch to these above PARALLEL_SORT_THRESHOLD files. The
+ * array is cut into one contiguous block per hardware thread.
+ *  - RadixSort: stable LSD radix sort on the 64-bit key, 8 bits per pass.
+ *    Each thread histograms its block, the histograms are prefix-summed in
+ *    (digit, thread) order, and each thread scatters its block straight to
+ *    its own offsets. Passes where every key has the same digit are skipped.
+ *  - MergeSort: each thread sorts its block, then runs are merged pairwise.
+ *    Every merge is cut into pieces with a merge-path binary search, so all
+ *    threads share even the final merge.
+ */
+class ParallelSort {
+public:
+    struct Entry {
+        uint64_t key;
+        File* file;
+    };
+
+    static unsigned threadLimit;  // 0 = one thread per core
+
+    static size_t Threads(size_t n) {
+        size_t cores = threadLimit ? threadLimit : max(1u, thread::hardware_concurrency());
+        return max<size_t>(1, min(cores, n / MIN_BLOCK));
+    }
+
+    // Runs fn(0) .. fn(tasks - 1), one per thread; the caller takes task 0
+    template <typename Fn>
+    static void Run(size_t tasks, Fn fn) {
+        vector<thread> workers;
+        workers.reserve(tasks);
+        for (size_t t = 1; t < tasks; t++) workers.emplace_back(fn, t);
+        if (tasks > 0) fn(0);
+        for (thread& w : workers) w.join();
+    }
+
+    static void RadixSort(vector<Entry>& v) {
+        size_t n = v.size(), threads = Threads(n);
+        if (n < 2) return;
+        vector<size_t> bounds = Blocks(n, threads);
+
+        // Digits where every key agrees need no pass
+        vector<uint64_t> diffs(threads, 0);
+        uint64_t first = v[0].key;
+        Run(threads, [&](size_t t) {
+            uint64_t d = 0;
+            for (size_t i = bounds[t]; i < bounds[t + 1]; i++) d |= v[i].key ^ first;
+            diffs[t] = d;
+        });
+        uint64_t diff = 0;
+        for (uint64_t d : diffs) diff |= d;
+
+        vector<Entry> tmp(n);
+        vector<size_t> counts(threads * 256);
+        for (int shift = 0; shift < 64; shift += 8) {
+            if (((diff >> shift) & 0xFF) == 0) continue;
+            Run(threads, [&](size_t t) {
+                size_t* c = &counts[t * 256];
+                fill(c, c + 256, 0);
+                for (size_t i = bounds[t]; i < bounds[t + 1]; i++) c[(v[i].key >> shift) & 0xFF]++;
+            });
+            size_t offset = 0;
+            for (int d = 0; d < 256; d++) {
+                for (size_t t = 0; t < threads; t++) {
+                    size_t c = counts[t * 256 + d];
+                    counts[t * 256 + d] = offset;
+                    offset += c;
+                }
+            }
+            Run(threads, [&](size_t t) {
+                size_t* c = &counts[t * 256];
+                for (size_t i = bounds[t]; i < bounds[t + 1]; i++) tmp[c[(v[i].key >> shift) & 0xFF]++] = v[i];
+            });
+            v.swap(tmp);
+        }
+    }
+
+    template <typename Less>
+    static void MergeSort(vector<Entry>& v, Less less) {
+        size_t n = v.size(), threads = Threads(n);
+        if (threads == 1) {
+            stable_sort(v.begin(), v.end(), less);
+            return;
+        }
+        vector<size_t> runs = Blocks(n, threads);
+        Run(threads, [&](size_t t) { stable_sort(v.begin() + runs[t], v.begin() + runs[t + 1], less); });
+
+        struct Piece { size_t a, aEnd, b, bEnd, out; };
+        vector<Entry> tmp(n);
+        while (runs.size() > 2) {
+            vector<Piece> pieces;
+            vector<size_t> merged;
+            for (size_t r = 0; r + 1 < runs.size(); r += 2) {
+                size_t lo = runs[r], mid = runs[r + 1];
+                size_t hi = r + 2 < runs.size() ? runs[r + 2] : mid;  // An odd run out is just copied
+                merged.push_back(lo);
+                size_t parts = max<size_t>(1, threads * (hi - lo) / n);
+                size_t prevA = lo, prevB = mid;
+                for (size_t p = 1; p <= parts; p++) {
+                    size_t k = (hi - lo) * p / parts;
+                    size_t i = p == parts ? mid - lo : CoRank(v, lo, mid - lo, mid, hi - mid, k, less);
+                    pieces.push_back({prevA, lo + i, prevB, mid + (k - i), prevA + prevB - mid});
+                    prevA = lo + i;
+                    prevB = mid + (k - i);
+                }
+            }
+            merged.push_back(n);
+            Run(pieces.size(), [&](size_t p) {
+                const Piece& pc = pieces[p];
+                merge(v.begin() + pc.a, v.begin() + pc.aEnd, v.begin() + pc.b, v.begin() + pc.bEnd,
+                      tmp.begin() + pc.out, less);
+            });
+            v.swap(tmp);
+            runs.swap(merged);
+        }
+    }
+
+    /**
+     * @brief Sorts each run of equal keys with less, for keys that are only
+     *        a prefix of the real order. Runs are split between threads at
+     *        run boundaries.
+     */
+    template <typename Less>
+    static void SortTies(vector<Entry>& v, Less less) {
+        size_t n = v.size(), threads = Threads(n);
+        vector<size_t> bounds = Blocks(n, threads);
+        for (size_t t = 1; t < threads; t++) {  // Move each cut to the start of a run
+            size_t& b = bounds[t];
+            b = max(b, bounds[t - 1]);
+            while (b > bounds[t - 1] && b < n && v[b].key == v[b - 1].key) b++;
+        }
+        Run(threads, [&](size_t t) {
+            size_t i = bounds[t], end = bounds[t + 1];
+            while (i < end) {
+                size_t j = i + 1;
+                while (j < n && v[j].key == v[i].key) j++;
+                if (j - i > 1) sort(v.begin() + i, v.begin() + j, less);
+                i = j;
+            }
+        });
+    }
+
+private:
+    static const size_t MIN_BLOCK = 16384;  // Smaller blocks cost more in thread start-up than they save
+
+    static vector<size_t> Blocks(size_t n, size_t threads) {
+        vector<size_t> bounds(threads + 1);
+        for (size_t t = 0; t <= threads; t++) bounds[t] = n * t / threads;
+        return bounds;
+    }
+
+    // How many of the first k merged entries come from A; ties take A first
+    template <typename Less>
+    static size_t CoRank(const vector<Entry>& v, size_t a, size_t aLen, size_t b, size_t bLen, size_t k, Less less) {
+        size_t lo = k > bLen ? k - bLen : 0, hi = min(k, aLen);
+        while (lo < hi) {
+            size_t i = lo + (hi - lo) / 2;
+            if (!less(v[b + k - i - 1], v[a + i])) lo = i + 1;
+            else hi = i;
+        }
+        return lo;
+    }
+};
+
+unsigned ParallelSort::threadLimit = 0;
+
+// Keys a folder's files can be listed by
+enum FileSortKey { SORT_BY_NAME, SORT_BY_SIZE, SORT_BY_PRIORITY, SORT_KEY_COUNT };
+
+/*
+ * Total orders for the secondary indexes; the file ID breaks ties. Prefix()
+ * maps a file to a pair of numbers in the same order, cached in the index
+ * nodes so most comparisons never dereference a File. When EXACT, equal
+ * prefixes mean equal keys and the IDs decide without looking at the files.
+ */
+struct SortPrefix {
+    uint64_t hi, lo;
+    bool operator==(const SortPrefix& o) const { return hi == o.hi && lo == o.lo; }
+    bool operator<(const SortPrefix& o) const { return hi != o.hi ? hi < o.hi : lo < o.lo; }
+};
+
+struct FileByName {
+    static const bool EXACT = false;
+    static SortPrefix Prefix(const File* f) {
+        SortPrefix p = {0, 0};  // First 16 bytes, big-endian, so it orders like the string
+        const string& n = f->GetName();
+        for (size_t i = 0; i < 16; i++) {
+            uint64_t& half = i < 8 ? p.hi : p.lo;
+            half = (half << 8) | (i < n.size() ? (unsigned char)n[i] : 0);
+        }
+        return p;
+    }
+    bool operator()(const File* a, const File* b) const {
+        int c = a->GetName().compare(b->GetName());
+        return c != 0 ? c < 0 : a->GetID() < b->GetID();
+    }
+};
+
+struct FileBySize {
+    static const bool EXACT = true;
+    static SortPrefix Prefix(const File* f) { return {(uint64_t)f->GetSize(), 0}; }
+    bool operator()(const File* a, const File* b) const {
+        return a->GetSize() != b->GetSize() ? a->GetSize() < b->GetSize() : a->GetID() < b->GetID();
+    }
+};
+
+struct FileByPriority {
+    static const bool EXACT = true;
+    static SortPrefix Prefix(const File* f) { return {(uint64_t)f->GetPriority(), 0}; }
+    bool operator()(const File* a, const File* b) const {
+        return a->GetPriority() != b->GetPriority() ? a->GetPriority() < b->GetPriority() : a->GetID() < b->GetID();
+    }
+};
+
+/**
+ * @class OrderIndex
+ * @brief Order-statistic AVL tree of File handles sorted by Compare.
+ *
+ * Each node also stores the size of its subtree, so the file at any rank is
+ * found in O(log n) and a page of a sorted listing costs that descent plus
+ * the page itself. Keys are read through the handle, so a file must be
+ * erased before anything its order depends on changes and re-inserted after.
+ * Nodes live in one vector and link by index.
+ */
+template <typename Compare>
+class OrderIndex {
+private:
+    struct Node {
+        SortPrefix prefix;  // Compare::Prefix(file)
+        File* file;
+        int id;
+        int left, right;
+        int height;
+        int size;
+    };
+    vector<Node> nodes;
+    vector<int> freeNodes;
+    int root;
+    Compare less;
+
+    // Does the file with this prefix and ID sort before node n?
+    bool Before(const SortPrefix& prefix, int id, const File* f, int n) const {
+        const Node& x = nodes[n];
+        if (!(prefix == x.prefix)) return prefix < x.prefix;
+        return Compare::EXACT ? id < x.id : less(f, x.file);
+    }
+
+    bool After(const SortPrefix& prefix, int id, const File* f, int n) const {
+        const Node& x = nodes[n];
+        if (!(prefix == x.prefix)) return x.prefix < prefix;
+        return Compare::EXACT ? id > x.id : less(x.file, f);
+    }
+
+    int Height(int n) const { return n == -1 ? 0 : nodes[n].height; }
+    int Count(int n) const { return n == -1 ? 0 : nodes[n].size; }
+
+    void Fix(int n) {
+        nodes[n].height = 1 + max(Height(nodes[n].left), Height(nodes[n].right));
+        nodes[n].size = 1 + Count(nodes[n].left) + Count(nodes[n].right);
+    }
+
+    int RotateRight(int y) {
+        int x = nodes[y].left;
+        nodes[y].left = nodes[x].right;
+        nodes[x].right = y;
+        Fix(y);
+        Fix(x);
+        return x;
+    }
+
+    int RotateLeft(int x) {
+        int y = nodes[x].right;
+        nodes[x].right = nodes[y].left;
+        nodes[y].left = x;
+        Fix(x);
+        Fix(y);
+        return y;
+    }
+
+    int Balance(int n) {
+        Fix(n);
+        int bf = Height(nodes[n].left) - Height(nodes[n].right);
+        if (bf > 1) {
+            if (Height(nodes[nodes[n].left].left) < Height(nodes[nodes[n].left].right))
+                nodes[n].left = RotateLeft(nodes[n].left);
+            return RotateRight(n);
+        }
+        if (bf < -1) {
+            if (Height(nodes[nodes[n].right].right) < Height(nodes[nodes[n].right].left))
+                nodes[n].right = RotateRight(nodes[n].right);
+            return RotateLeft(n);
+        }
+        return n;
+    }
+
+    int NewNode(File* f) {
+        int n;
+        if (!freeNodes.empty()) {
+            n = freeNodes.back();
+            freeNodes.pop_back();
+        } else {
+            n = nodes.size();
+            nodes.push_back(Node());
+        }
+        nodes[n] = {Compare::Prefix(f), f, f->GetID(), -1, -1, 1, 1};
+        return n;
+    }
+
+    int Insert(int n, File* f, const SortPrefix& prefix) {
+        if (n == -1) return NewNode(f);
+        if (Before(prefix, f->GetID(), f, n)) nodes[n].left = Insert(nodes[n].left, f, prefix);
+        else nodes[n].right = Insert(nodes[n].right, f, prefix);
+        return Balance(n);
+    }
+
+    // Unlinks the leftmost node of the subtree into minNode
+    int EraseMin(int n, int& minNode) {
+        if (nodes[n].left == -1) {
+            minNode = n;
+            return nodes[n].right;
+        }
+        nodes[n].left = EraseMin(nodes[n].left, minNode);
+        return Balance(n);
+    }
+
+    int Erase(int n, const File* f, const SortPrefix& prefix) {
+        if (n == -1) return -1;
+        if (Before(prefix, f->GetID(), f, n)) {
+            nodes[n].left = Erase(nodes[n].left, f, prefix);
+        } else if (After(prefix, f->GetID(), f, n)) {
+            nodes[n].right = Erase(nodes[n].right, f, prefix);
+        } else {
+            int left = nodes[n].left, right = nodes[n].right;
+            freeNodes.push_back(n);
+            if (right == -1) return left;
+            int successor;
+            right = EraseMin(right, successor);
+            nodes[successor].left = left;
+            nodes[successor].right = right;
+            return Balance(successor);
+        }
+        return Balance(n);
+    }
+
+public:
+    OrderIndex() : root(-1) {}
+
+    OrderIndex(OrderIndex&& other) noexcept
+        : nodes(move(other.nodes)), freeNodes(move(other.freeNodes)), root(other.root) {
+        other.root = -1;
+    }
+
+    OrderIndex& operator=(OrderIndex&& other) noexcept {
+        if (this != &other) {
+            nodes = move(other.nodes);
+            freeNodes = move(other.freeNodes);
+            root = other.root;
+            other.Clear();
+        }
+        return *this;
+    }
+
+    void Insert(File* f) { root = Insert(root, f, Compare::Prefix(f)); }
+    void Erase(const File* f) { root = Erase(root, f, Compare::Prefix(f)); }
+    size_t Size() const { return Count(root); }
+
+    void Clear() {
+        vector<Node>().swap(nodes);
+        vector<int>().swap(freeNodes);
+        root = -1;
+    }
+
+    /**
+     * @brief Calls fn(file) for up to count files starting at rank first,
+     *        in ascending order (or descending, counting from the end).
+     */
+    template <typename Fn>
+    void Page(size_t first, size_t count, bool descending, Fn fn) const {
+        auto nearChild = [&](int n) { return descending ? nodes[n].right : nodes[n].left; };
+        auto farChild = [&](int n) { return descending ? nodes[n].left : nodes[n].right; };
+
+        // Descend to the first rank; the stack keeps the ancestors still to visit
+        vector<int> stack;
+        int n = root;
+        size_t k = first;
+        while (n != -1) {
+            size_t before = Count(nearChild(n));
+            if (k < before) {
+                stack.push_back(n);
+                n = nearChild(n);
+            } else if (k == before) {
+                stack.push_back(n);
+                break;
+            } else {
+                k -= before + 1;
+                n = farChild(n);
+            }
+        }
+
+        while (count > 0 && !stack.empty()) {
+            n = stack.back();
+            stack.pop_back();
+            fn(nodes[n].file);
+            count--;
+            for (int c = farChild(n); c != -1; c = nearChild(c)) stack.push_back(c);
+        }
+    }
+};
+
+/**
+ * @class HashTableFiles
+ * @brief Stores a folder's files in a SwissTable keyed by file ID.
+ *
+ * The table owns every File through a pointer, so a File keeps its address
+ * while it is in the folder. Growing, shrinking after mass deletes and
+ * purging DELETED markers all work the same way: a new table is allocated
+ * and the old one drains into it REHASH_STEP groups per Insert, Search or
+ * Delete, so no single call rehashes the whole folder. Until it is empty,
+ * lookups check the new table first and then the old one.
+ *
+ * Sorted indexes on name, size and priority are kept in step with every
+ * Insert, Delete and Update, so a sorted page never looks at other files.
+ */
+class HashTableFiles {
+    friend class DriveSnapshot;
+private:
+    static const size_t REHASH_STEP = 4;   // Old groups scanned per call
+
+    SwissTable table;
+    SwissTable oldTable;       // Being drained; capacity 0 when no rebuild is in progress
+    size_t migrateIndex;       // Next slot of oldTable to move
+    int currentSize;           // Live files across both tables
+    OrderIndex<FileByName> byName;
+    OrderIndex<FileBySize> bySize;
+    OrderIndex<FileByPriority> byPriority;
+
+    void Index(File* f) {
+        byName.Insert(f);
+        bySize.Insert(f);
+        byPriority.Insert(f);
+    }
+
+    void Unindex(const File* f) {
+        byName.Erase(f);
+        bySize.Erase(f);
+        byPriority.Erase(f);
+    }
+
+    bool Migrating() const { return oldTable.Capacity() != 0; }
+
+    void MigrateStep(size_t slots) {
+        while (Migrating() && slots-- > 0) {
+            File* f = oldTable.At(migrateIndex);
+            if (f) {
+                oldTable.EraseAt(migrateIndex);
+                table.Insert(f);
+            }
+            if (++migrateIndex == oldTable.Capacity()) oldTable = SwissTable();
+        }
+    }
+
+    /**
+     * @brief Starts draining into a fresh table sized for the live files
+     *        plus every insert that can happen before the drain finishes,
+     *        at half load so it does not need rebuilding again right away.
+     */
+    void Rebuild() {
+        if (Migrating()) {
+            // Not expected (the sizing below keeps the drain ahead of inserts): merge both at once
+            SwissTable merged(currentSize * 2 + SwissTable::GROUP);
+            ForEach([&merged](const File& f) { merged.Insert(const_cast<File*>(&f)); });
+            table = move(merged);
+            oldTable = SwissTable();
+        }
+        size_t oldCap = table.Capacity();
+        size_t expected = currentSize + oldCap / (REHASH_STEP * SwissTable::GROUP) + 1;
+        oldTable = move(table);
+        migrateIndex = 0;
+        table = SwissTable(expected * 2);
+    }
+
+    long Locate(int id, SwissTable*& owner) {
+        long i = table.Find(id);
+        owner = &table;
+        if (i < 0 && Migrating()) {
+            i = oldTable.Find(id);
+            owner = &oldTable;
+        }
+        return i;
+    }
+
+    void CopyFrom(const HashTableFiles& other) {
+        currentSize = other.currentSize;
+        migrateIndex = 0;
+        table = SwissTable(max<size_t>(currentSize * 2, other.table.Capacity()));
+        other.ForEach([this](const File& f) {
+            File* copy = new File(f);  // Deep copy each File
+            table.Insert(copy);
+            Index(copy);
+        });
+    }
+
+    void Release() {
+        byName.Clear();
+        bySize.Clear();
+        byPriority.Clear();
+        ForEach([](const File& f) { delete &f; });
+        table = SwissTable();
+        oldTable = SwissTable();
+        currentSize = 0;
+    }
+
+public:
+    HashTableFiles(int cap = INITIAL_HASH_SIZE) : table(cap), migrateIndex(0), currentSize(0) {}
+
+    // Copy constructor - CRITICAL: Prevents shallow copy crashes
+    HashTableFiles(const HashTableFiles& other) {
+        CopyFrom(other);
+    }
+
+    // Copy assignment operator - CRITICAL: Prevents shallow copy crashes
+    HashTableFiles& operator=(const HashTableFiles& other) {
+        if (this != &other) {
+            Release();  // Free existing memory
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    // Moves take the tables (and so every File) without touching a single file
+    HashTableFiles(HashTableFiles&& other) noexcept
+        : table(move(other.table)), oldTable(move(other.oldTable)),
+          migrateIndex(other.migrateIndex), currentSize(other.currentSize),
+          byName(move(other.byName)), bySize(move(other.bySize)), byPriority(move(other.byPriority)) {
+        other.migrateIndex = 0;
+        other.currentSize = 0;
+    }
+
+    HashTableFiles& operator=(HashTableFiles&& other) noexcept {
+        if (this != &other) {
+            Release();
+            table = move(other.table);
+            oldTable = move(other.oldTable);
+            migrateIndex = other.migrateIndex;
+            currentSize = other.currentSize;
+            byName = move(other.byName);
+            bySize = move(other.bySize);
+            byPriority = move(other.byPriority);
+            other.migrateIndex = 0;
+            other.currentSize = 0;
+        }
+        return *this;
+    }
+
+    ~HashTableFiles() { 
+        Release();
+    }
+
+    void Insert(File f) {
+        MigrateStep(REHASH_STEP * SwissTable::GROUP);
+        if (f.GetID() <= 0) return;
+        SwissTable* owner;
+        if (Locate(f.GetID(), owner) >= 0) {
+            cout << " [Error] Duplicate File ID.\n";
+            return;
+        }
+        if (!table.HasRoom()) Rebuild();
+        File* added = new File(move(f));
+        table.Insert(added);
+        Index(added);
+        currentSize++;
+    }
+
+    // The returned pointer stays valid until that file is deleted
+    File* Search(int id) {
+        MigrateStep(REHASH_STEP * SwissTable::GROUP);
+        SwissTable* owner;
+        long i = Locate(id, owner);
+        return i >= 0 ? owner->At(i) : nullptr;
+    }
+
+    File Delete(int id) {
+        MigrateStep(REHASH_STEP * SwissTable::GROUP);
+        SwissTable* owner;
+        long i = Locate(id, owner);
+        if (i < 0) return File();
+        File* slot = owner->At(i);
+        owner->EraseAt(i);
+        Unindex(slot);
+        File temp = move(*slot);
+        delete slot;
+        currentSize--;
+        // Shrink once the table is mostly air
+        if (!Migrating() && table.Capacity() > 4 * SwissTable::GROUP && (size_t)currentSize * 8 < table.Capacity()) Rebuild();
+        return temp;
+    }
+
+    /**
+     * @brief  Applies change to a file, re-sorting it in the indexes. Any
+     *         change to a live file's name, size or priority must go through here.
+     * @return false if the file does not exist.
+     */
+    template <typename Change>
+    bool Update(int id, Change change) {
+        File* f = Search(id);
+        if (!f) return false;
+        Unindex(f);
+        change(*f);
+        Index(f);
+        return true;
+    }
+
+    // Calls fn on every live file
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        table.ForEach(fn);
+        oldTable.ForEach(fn);
+    }
+
+    int Size() const { return currentSize; }
+
+    /**
+     * @brief Calls fn(file) for page number `page` (from 0) of the files
+     *        sorted by key. O(log n + pageSize).
+     */
+    template <typename Fn>
+    void Page(FileSortKey key, bool descending, size_t page, size_t pageSize, Fn fn) const {
+        size_t first = page * pageSize;
+        switch (key) {
+            case SORT_BY_NAME: byName.Page(first, pageSize, descending, fn); break;
+            case SORT_BY_SIZE: bySize.Page(first, pageSize, descending, fn); break;
+            default: byPriority.Page(first, pageSize, descending, fn); break;
+        }
+    }
+
+    void DisplayAll(FileSortKey key = SORT_BY_NAME, bool descending = false, size_t page = 0,
+                    size_t pageSize = FILE_PAGE_SIZE) const {
+        if (currentSize == 0) { cout << " (Folder is empty)\n"; return; }
+        
+        cout << " ---------------------------------------------------------\n";
+        cout << "   ID  |      NAME       | TYPE  | SIZE   | PRIORITY \n";
+        cout << " ---------------------------------------------------------\n";
+        Page(key, descending, page, pageSize, [](const File* f) { f->DisplayRow(); });
+        cout << " ---------------------------------------------------------\n";
+        size_t pages = (currentSize + pageSize - 1) / pageSize;
+        cout << " Page " << min(page + 1, pages) << " of " << pages << " (" << currentSize << " files)\n";
+    }
+
+    // Helper to get handles for sorting; the sorts move pointers, never Files
+    vector<File*> GetFilesVector() {
+        vector<File*> v;
+        v.reserve(currentSize);
+        ForEach([&v](File& f) { v.push_back(&f); });
+        return v;
+    }
+
+    /**
+     * @brief Sorts the handles on every core through (key, handle) pairs:
+     *        radix on the key, or merge sort with the full comparison.
+     *        Names are keyed by their first 8 bytes and ties re-sorted.
+     */
+    static void ParallelSortFiles(vector<File*>& v, FileSortKey key, bool radix, bool foldCase = false) {
+        typedef ParallelSort::Entry Entry;
+        vector<Entry> entries(v.size());
+        size_t threads = ParallelSort::Threads(v.size());
+        ParallelSort::Run(threads, [&](size_t t) {
+            for (size_t i = v.size() * t / threads; i < v.size() * (t + 1) / threads; i++) {
+                uint64_t k = 0;
+                if (key == SORT_BY_SIZE) {
+                    k = v[i]->GetSize();
+                } else {
+                    const string& name = v[i]->GetName();
+                    for (size_t c = 0; c < 8; c++) {
+                        unsigned char ch = c < name.size() ? name[c] : 0;
+                        k = (k << 8) | (foldCase ? tolower(ch) : ch);
+                    }
+                }
+                entries[i] = {k, v[i]};
+            }
+        });
+
+        auto nameLess = [foldCase](const Entry& a, const Entry& b) {
+            if (a.key != b.key) return a.key < b.key;
+            const string& x = a.file->GetName();
+            const string& y = b.file->GetName();
+            if (!foldCase) return x < y;
+            return lexicographical_compare(x.begin(), x.end(), y.begin(), y.end(), [](char p, char q) {
+                return tolower((unsigned char)p) < tolower((unsigned char)q);
+            });
+        };
+        if (radix) {
+            ParallelSort::RadixSort(entries);
+            if (key != SORT_BY_SIZE) ParallelSort::SortTies(entries, nameLess);
+        } else if (key == SORT_BY_SIZE) {
+            ParallelSort::MergeSort(entries, [](const Entry& a, const Entry& b) { return a.key < b.key; });
+        } else {
+            ParallelSort::MergeSort(entries, nameLess);
+        }
+
+        ParallelSort::Run(threads, [&](size_t t) {
+            for (size_t i = v.size() * t / threads; i < v.size() * (t + 1) / threads; i++) v[i] = entries[i].file;
+        });
+    }
+
+    static void SortBanner(const string& title, size_t n) {
+        cout << "\n [" << title;
+        if (n >= PARALLEL_SORT_THRESHOLD) cout << " - PARALLEL ON " << ParallelSort::Threads(n) << " THREADS";
+        cout << "]\n";
+    }
+
+    // 1. Bubble Sort (Size)
+    void SortBubbleSize(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) {
+            ParallelSortFiles(v, SORT_BY_SIZE, false);
+        } else {
+            for (size_t i = 0; i + 1 < v.size(); i++)
+                for (size_t j = 0; j < v.size() - i - 1; j++)
+                    if (v[j]->GetSize() > v[j+1]->GetSize())
+                        swap(v[j], v[j+1]);
+        }
+
+        if (!display) return;
+        SortBanner("SORTED BY SIZE (BUBBLE SORT)", v.size());
+        for(auto& f : v) f->DisplayRow();
+    }
+
+    // 2. Quick Sort (Name)
+    int Partition(vector<File*>& v, int low, int high) {
+        const string& pivot = v[high]->GetName();
+        int i = (low - 1);
+        for (int j = low; j <= high - 1; j++) {
+            if (v[j]->GetName() < pivot) {
+                i++;
+                swap(v[i], v[j]);
+            }
+        }
+        swap(v[i + 1], v[high]);
+        return (i + 1);
+    }
+
+    void QuickSort(vector<File*>& v, int low, int high) {
+        if (low < high) {
+            int pi = Partition(v, low, high);
+            QuickSort(v, low, pi - 1);
+            QuickSort(v, pi + 1, high);
+        }
+    }
+
+    void SortQuickName(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) ParallelSortFiles(v, SORT_BY_NAME, false);
+        else if(!v.empty()) QuickSort(v, 0, v.size()-1);
+        if (!display) return;
+        SortBanner("SORTED BY NAME (QUICK SORT - O(n log n))", v.size());
+        for(auto& f : v) f->DisplayRow();
+    }
+
+    // 3. Insertion Sort (Size)
+    void SortInsertionSize(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) {
+            ParallelSortFiles(v, SORT_BY_SIZE, false);
+        } else {
+            for (size_t i = 1; i < v.size(); i++) {
+                File* key = v[i];
+                int j = i - 1;
+                while (j >= 0 && v[j]->GetSize() > key->GetSize()) {
+                    v[j + 1] = v[j];
+                    j--;
+                }
+                v[j + 1] = key;
+            }
+        }
+        
+        if (!display) return;
+        SortBanner("SORTED BY SIZE (INSERTION SORT - O(n²))", v.size());
+        for(auto& f : v) f->DisplayRow();
+    }
+
+    // 4. Selection Sort (Size)
+    void SortSelectionSize(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) {
+            ParallelSortFiles(v, SORT_BY_SIZE, false);
+        } else {
+            for (size_t i = 0; i + 1 < v.size(); i++) {
+                int minIdx = i;
+                for (size_t j = i + 1; j < v.size(); j++) {
+                    if (v[j]->GetSize() < v[minIdx]->GetSize()) {
+                        minIdx = j;
+                    }
+                }
+                swap(v[i], v[minIdx]);
+            }
+        }
+        
+        if (!display) return;
+        SortBanner("SORTED BY SIZE (SELECTION SORT - O(n²))", v.size());
+        for(auto& f : v) f->DisplayRow();
+    }
+
+    // 5. Merge Sort (Size)
+    void Merge(vector<File*>& arr, int left, int mid, int right) {
+        int n1 = mid - left + 1;
+        int n2 = right - mid;
+        
+        vector<File*> L(n1), R(n2);
+        for (int i = 0; i < n1; i++) L[i] = arr[left + i];
+        for (int j = 0; j < n2; j++) R[j] = arr[mid + 1 + j];
+        
+        int i = 0, j = 0, k = left;
+        while (i < n1 && j < n2) {
+            if (L[i]->GetSize() <= R[j]->GetSize()) {
+                arr[k] = L[i++];
+            } else {
+                arr[k] = R[j++];
+            }
+            k++;
+        }
+        
+        while (i < n1) arr[k++] = L[i++];
+        while (j < n2) arr[k++] = R[j++];
+    }
+
+    void MergeSort(vector<File*>& arr, int left, int right) {
+        if (left < right) {
+            int mid = left + (right - left) / 2;
+            MergeSort(arr, left, mid);
+            MergeSort(arr, mid + 1, right);
+            Merge(arr, left, mid, right);
+        }
+    }
+
+    void SortMergeSize(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) ParallelSortFiles(v, SORT_BY_SIZE, false);
+        else if (!v.empty()) MergeSort(v, 0, v.size() - 1);
+        if (!display) return;
+        SortBanner("SORTED BY SIZE (MERGE SORT - O(n log n))", v.size());
+        for(auto& f : v) f->DisplayRow();
+    }
+
+    // 6. Heap Sort (Size)
+    void Heapify(vector<File*>& arr, int n, int i) {
+        int largest = i;
+        int left = 2 * i + 1;
+        int right = 2 * i + 2;
+        
+        if (left < n && arr[left]->GetSize() > arr[largest]->GetSize())
+            largest = left;
+        if (right < n && arr[right]->GetSize() > arr[largest]->GetSize())
+            largest = right;
+        
+        if (largest != i) {
+            swap(arr[i], arr[largest]);
+            Heapify(arr, n, largest);
+        }
+    }
+
+    void SortHeapSize(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        int n = v.size();
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) {
+            ParallelSortFiles(v, SORT_BY_SIZE, false);
+            n = 0;  // Already sorted; skip the heap passes
+        }
+        
+        // Build max heap
+        for (int i = n / 2 - 1; i >= 0; i--)
+            Heapify(v, n, i);
+        
+        // Extract elements one by one
+        for (int i = n - 1; i > 0; i--) {
+            swap(v[0], v[i]);
+            Heapify(v, i, 0);
+        }
+        
+        if (!display) return;
+        SortBanner("SORTED BY SIZE (HEAP SORT - O(n log n))", v.size());
+        for(auto& f : v) f->DisplayRow();
+    }
+
+    // 7. Counting Sort (Size) - O(n+k)
+    // Sizes are 64-bit, so the count array covers one 16-bit digit at a time
+    // (stable passes from the lowest digit up) instead of every possible size.
+    void SortCountingSize(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        if (v.empty()) return;
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) {
+            ParallelSortFiles(v, SORT_BY_SIZE, true);
+            if (!display) return;
+            SortBanner("SORTED BY SIZE (COUNTING SORT - O(n+k))", v.size());
+            for(auto& f : v) f->DisplayRow();
+            return;
+        }
+        
+        // Find max size
+        int64_t maxSize = v[0]->GetSize();
+        for (auto& f : v) {
+            if (f->GetSize() > maxSize) maxSize = f->GetSize();
+        }
+        
+        vector<File*> output(v.size());
+        for (int shift = 0; shift == 0 || (shift < 64 && (maxSize >> shift) > 0); shift += 16) {
+            // Count array
+            vector<int> count(1 << 16, 0);
+            for (auto& f : v) count[(f->GetSize() >> shift) & 0xFFFF]++;
+            
+            // Cumulative count
+            for (int i = 1; i < (1 << 16); i++) count[i] += count[i - 1];
+            
+            // Output array
+            for (int i = v.size() - 1; i >= 0; i--) {
+                int digit = (v[i]->GetSize() >> shift) & 0xFFFF;
+                output[count[digit] - 1] = v[i];
+                count[digit]--;
+            }
+            v.swap(output);
+        }
+        output.swap(v);
+        
+        if (!display) return;
+        SortBanner("SORTED BY SIZE (COUNTING SORT - O(n+k))", output.size());
+        for(auto& f : output) f->DisplayRow();
+    }
+
+    // 8. Radix Sort (Name) - O(d*n)
+    void RadixSortNames(vector<File*>& arr) {
+        if (arr.empty()) return;
+        
+        // Get max length
+        int maxLen = 0;
+        for (auto& f : arr) {
+            int len = f->GetName().length();
+            if (len > maxLen) maxLen = len;
+        }
+        
+        // Sort by each character position (right to left)
+        for (int pos = maxLen - 1; pos >= 0; pos--) {
+            vector<File*> output(arr.size());
+            vector<int> count(256, 0);  // ASCII characters
+            
+            // Count occurrences
+            for (auto& f : arr) {
+                unsigned char ch = (pos < f->GetName().length()) ? tolower(f->GetName()[pos]) : 0;
+                count[ch]++;
+            }
+            
+            // Cumulative count
+            for (int i = 1; i < 256; i++) count[i] += count[i - 1];
+            
+            // Build output
+            for (int i = arr.size() - 1; i >= 0; i--) {
+                unsigned char ch = (pos < arr[i]->GetName().length()) ? tolower(arr[i]->GetName()[pos]) : 0;
+                output[count[ch] - 1] = arr[i];
+                count[ch]--;
+            }
+            
+            arr.swap(output);
+        }
+    }
+
+    void SortRadixName(bool display = true) {
+        vector<File*> v = GetFilesVector();
+        if (v.size() >= PARALLEL_SORT_THRESHOLD) ParallelSortFiles(v, SORT_BY_NAME, true, true);  // Same case folding
+        else if (!v.empty()) RadixSortNames(v);
+        if (!display) return;
+        SortBanner("SORTED BY NAME (RADIX SORT - O(d*n))", v.size());
+        for(auto& f : v) f->DisplayRow();
+    }
+};
+
+class Folder {
+    friend class DriveSnapshot;
+private:
+    string name;
+    string owner;
+    int id;
+    int fileIDCounter;
+    
+    HashTableFiles files;
+    FileStack deletedFiles;
+    RecentFiles recentFiles;
+    FileMaxHeap starredFiles;
+    FileDoubleLinkedList fileNavigator;  // For file browsing
+    TrashPolicy* trashPolicy;            // Owner's trash limits; null until the folder is placed
+
+    // Files of priority 8 and up are starred automatically
+    void UpdateStarred(int fileID, int prio) {
+        if (prio >= 8) starredFiles.Insert(fileID, prio);
+        else starredFiles.Remove(fileID);
+    }
+
+    // Gives the trash one expiry timer in the owner's wheel while it holds files
+    void ArmTrashTimer() {
+        if (!trashPolicy || deletedFiles.IsEmpty() || deletedFiles.TimerArmed()) return;
+        trashPolicy->Schedule(id, deletedFiles.OldestDeletedAt() + trashPolicy->Retention());
+        deletedFiles.SetTimerArmed(true);
+    }
+
+public:
+    Folder() : id(0), fileIDCounter(1), trashPolicy(nullptr) {}
+    
+    // Copy constructor - CRITICAL: Ensures all members are properly copied
+    // (the navigator holds handles into other's table, so the copy starts without one)
+    Folder(const Folder& other) 
+        : name(other.name), owner(other.owner), id(other.id), 
+          fileIDCounter(other.fileIDCounter),
+          files(other.files),  // HashTableFiles now has proper copy semantics
+          deletedFiles(other.deletedFiles),  // FileStack uses array, safe
+          recentFiles(other.recentFiles),  // IDs and times only, safe
+          starredFiles(other.starredFiles),  // FileMaxHeap uses vector, safe
+          trashPolicy(other.trashPolicy)
+    {}
+    
+    // Copy assignment operator - CRITICAL: Ensures safe assignment
+    Folder& operator=(const Folder& other) {
+        if (this != &other) {
+            name = other.name;
+            owner = other.owner;
+            id = other.id;
+            fileIDCounter = other.fileIDCounter;
+            files = other.files;
+            deletedFiles = other.deletedFiles;
+            recentFiles = other.recentFiles;
+            starredFiles = other.starredFiles;
+            fileNavigator.Clear();
+            trashPolicy = other.trashPolicy;
+        }
+        return *this;
+    }
+
+    // Moves keep every File at its address, so the navigator's handles stay valid
+    Folder(Folder&& other) noexcept = default;
+    Folder& operator=(Folder&& other) noexcept = default;
+
+    void SetValues(const string &n, int i, const string &own) {
+        name = n; id = i; owner = own;
+    }
+
+    void SetTrashPolicy(TrashPolicy* policy) {
+        trashPolicy = policy;
+        deletedFiles.SetTimerArmed(false);
+        if (trashPolicy) deletedFiles.Trim(trashPolicy->Capacity());
+        ArmTrashTimer();
+    }
+
+    /**
+     * @brief  Drops trashed files older than the retention period. Called by
+     *         the owner's wheel when this folder's timer fires.
+     * @return How many files expired.
+     */
+    size_t ExpireTrash(int64_t now) {
+        deletedFiles.SetTimerArmed(false);
+        if (!trashPolicy) return 0;
+        size_t expired = deletedFiles.PurgeExpired(now - trashPolicy->Retention());
+        if (expired) sysLog.Log("TrashExpired", to_string(expired) + " file(s) expired from " + name);
+        ArmTrashTimer();
+        return expired;
+    }
+    
+    string GetName() const { return name; }
+    int GetID() const { return id; }
+    int GetFileIDCounter() const { return fileIDCounter; }
+
+    /**
+     * @brief  Creates a file without any prompts.
+     * @return ID of the new file.
+     */
+    int CreateFile(const string &fname, const string &type, const string &content, int prio) {
+        File f;
+        f.SetValues(fileIDCounter, fname, type, owner, content, prio);
+        files.Insert(move(f));
+        UpdateStarred(fileIDCounter, prio);
+
+        sysLog.Log("FileCreated", "File " + fname + " created in " + name);
+        journal.Append(JournalRecord(JOP_CREATE_FILE).Str(owner).Int(id).Int(fileIDCounter)
+                       .Str(fname).Str(type).Int(prio).Str(content));
+        return fileIDCounter++;
+    }
+
+    void CreateFile() {
+        PrintHeader("CREATE NEW FILE");
+        string fname = InputString(" Enter file name: ");
+        string type = InputString(" Enter file type (txt/doc/cpp): ");
+        string content = InputString(" Enter content: ");
+        int prio = InputInt(" Enter Priority (1-10): ", 1, 10);
+        
+        int newID = CreateFile(fname, type, content, prio);
+        cout << " [SUCCESS] File '" << fname << "' created (ID: " << newID << ").\n";
+    }
+
+    /**
+     * @brief  Adds a file whose content was already streamed into chunks.
+     * @return ID of the new file.
+     */
+    int AddStreamedFile(const string &fname, const string &type, ChunkList &&content, CodecID codec, int prio) {
+        File f;
+        f.SetValues(fileIDCounter, fname, type, owner, move(content), codec, prio);
+        int64_t size = f.GetSize();
+        files.Insert(move(f));
+        UpdateStarred(fileIDCounter, prio);
+
+        sysLog.Log("FileUploaded", "File " + fname + " (" + to_string(size) + " bytes) uploaded to " + name);
+        journal.Append(JournalRecord(JOP_UPLOAD_COMMIT).Str(owner).Int(id).Int(fileIDCounter).Int(codec));
+        return fileIDCounter++;
+    }
+
+    /**
+     * @brief  Streams a file from disk into the drive in FILE_IO_BLOCK pieces.
+     *         Every new chunk is journaled as soon as it is stored, so large
+     *         uploads never need the whole content in memory.
+     * @return ID of the new file, or -1 if the source could not be read.
+     */
+    int UploadFile(const string &path, const string &fname, const string &type, int prio) {
+        ifstream in(path, ios::binary);
+        if (!in) return -1;
+        int newID = fileIDCounter;
+        journal.Append(JournalRecord(JOP_UPLOAD_BEGIN).Str(owner).Int(id).Int(newID).Str(fname).Str(type).Int(prio));
+
+        FileWriter writer([this, newID](uint32_t chunk) {
+            if (!journal.IsOpen()) return;
+            const Sha256::Digest& hash = chunkStore.Hash(chunk);
+            // Bytes already in the store are recorded by hash only
+            bool isNew = chunkStore.Refs(chunk) == 1;
+            journal.Append(JournalRecord(JOP_UPLOAD_CHUNK).Str(owner).Int(id).Int(newID)
+                           .Str(string((const char*)hash.bytes, 32)).Int(chunkStore.Codec(chunk))
+                           .Int(chunkStore.Size(chunk)).Str(isNew ? chunkStore.Encoded(chunk) : string()));
+        });
+        vector<char> block(FILE_IO_BLOCK);
+        while (in.read(block.data(), block.size()) || in.gcount() > 0) {
+            writer.Write(block.data(), in.gcount());
+        }
+        if (in.bad()) return -1;  // Never committed, so recovery drops the chunks too
+        ChunkList content = writer.Finish();
+        return AddStreamedFile(fname, type, move(content), writer.Codec(), prio);
+    }
+
+    void UploadFile() {
+        PrintHeader("UPLOAD FILE FROM DISK");
+        string path = InputString(" Enter path of the file to upload: ");
+        string fname = InputString(" Enter file name: ");
+        string type = InputString(" Enter file type (txt/doc/cpp): ");
+        int prio = InputInt(" Enter Priority (1-10): ", 1, 10);
+
+        int newID = UploadFile(path, fname, type, prio);
+        if (newID == -1) {
+            cout << " [ERROR] Cannot read '" << path << "'.\n";
+            return;
+        }
+        cout << " [SUCCESS] File '" << fname << "' uploaded (ID: " << newID << ", "
+             << files.Search(newID)->GetSize() << " bytes).\n";
+    }
+
+    // Streams the latest version of a file to disk one chunk at a time
+    bool DownloadFile(int fileId, const string &path) {
+        File* f = files.Search(fileId);
+        if (!f) return false;
+        FileReader reader = f->OpenVersion(f->GetVersionCount());
+        ofstream out(path, ios::binary | ios::trunc);
+        if (!out) return false;
+        recentFiles.Touch(fileId, NowMicros());
+        string piece;
+        uint64_t written = 0;
+        while (reader.Next(piece)) {
+            out.write(piece.data(), piece.size());
+            written += piece.size();
+        }
+        sysLog.Log("FileDownloaded", "File " + f->GetName() + " saved to " + path);
+        return out.good() && written == reader.Size();
+    }
+
+    void DownloadFile() {
+        int fileId = InputInt(" Enter File ID to download: ");
+        string path = InputString(" Enter destination path: ");
+        if (DownloadFile(fileId, path)) {
+            cout << " [SUCCESS] Saved to '" << path << "'.\n";
+        } else {
+            cout << " [ERROR] File not found or destination not writable.\n";
+        }
+    }
+
+    void InsertSharedFile(File f) {
+        f.SetID(fileIDCounter++);
+        UpdateStarred(f.GetID(), f.GetPriority());
+        files.Insert(move(f));
+    }
+
+    // Looks up a file and records the access in Recent Files
+    File* SearchFile(int searchId) {
+        File* f = files.Search(searchId);
+        if (f) {
+            recentFiles.Touch(searchId, NowMicros());
+            sysLog.Log("FileAccessed", "Viewed file ID " + to_string(searchId));
+        }
+        return f;
+    }
+
+    void SearchFile() {
+        int searchId = InputInt(" Enter File ID to search: ");
+        File* f = SearchFile(searchId);
+        if (f) {
+            f->DisplayDetailed();
+        } else {
+            cout << " [ERROR] File not found.\n";
+        }
+    }
+
+    /**
+     * @brief  Moves a file to the trash, stamped with deletedAt (journal replay
+     *         passes the original time).
+     * @return false if the file does not exist.
+     */
+    bool DeleteFile(int delId, int64_t deletedAt) {
+        File f = files.Delete(delId);
+        if (f.GetID() <= 0) return false;
+        deletedFiles.Push(move(f), deletedAt, trashPolicy ? trashPolicy->Capacity() : DEFAULT_TRASH_CAPACITY);
+        ArmTrashTimer();
+        recentFiles.Remove(delId);
+        starredFiles.Remove(delId);
+        sysLog.Log("FileDeleted", "Deleted file ID " + to_string(delId));
+        journal.Append(JournalRecord(JOP_DELETE_FILE).Str(owner).Int(id).Int(delId).Int(deletedAt));
+        return true;
+    }
+
+    bool DeleteFile(int delId) { return DeleteFile(delId, time(nullptr)); }
+
+    void DeleteFile() {
+        int delId = InputInt(" Enter File ID to delete: ");
+        if (DeleteFile(delId)) {
+            cout << " [SUCCESS] File moved to Trash.\n";
+        } else {
+            cout << " [ERROR] File not found.\n";
+        }
+    }
+
+    /**
+     * @brief  Pops the most recently deleted file back into the folder.
+     * @return The restored file, or nullptr if the trash is empty.
+     */
+    File* RestoreFromTrash() {
+        if (deletedFiles.IsEmpty()) return nullptr;
+        File f = deletedFiles.Pop();
+        int restoredID = f.GetID();
+        sysLog.Log("FileRestored", "Restored file " + f.GetName());
+        UpdateStarred(restoredID, f.GetPriority());
+        files.Insert(move(f));
+        journal.Append(JournalRecord(JOP_RECOVER_FILE).Str(owner).Int(id));
+        return files.Search(restoredID);
+    }
+
+    void ShowRecentFiles() {
+        if (recentFiles.Size() == 0) { cout << " (No recent files)\n"; return; }
+        int i = 0;
+        recentFiles.ForEach([this, &i](const RecentFiles::Access& a) {
+            const File* f = files.Search(a.fileID);
+            if (!f) return;
+            cout << "  " << ++i << ". " << f->GetName() << " (Accessed: "
+                 << FormatTimestamp(a.accessedAt / 1000000) << ")\n";
+        });
+    }
+
+    const RecentFiles& GetRecentFiles() const { return recentFiles; }
+
+    void RecoverFile() {
+        if(deletedFiles.IsEmpty()) {
+            cout << " [INFO] Trash is empty.\n";
+            return;
+        }
+        File* f = RestoreFromTrash();
+        if (f) cout << " [SUCCESS] Restored '" << f->GetName() << "'.\n";
+    }
+
+    /**
+     * @brief Runs one of the sorting algorithms by its menu number (11-18).
+     * @param display Print the sorted rows; scripted runs pass false.
+     */
+    void RunSort(int option, bool display = true) {
+        switch(option) {
+            case 11: files.SortBubbleSize(display); break;
+            case 12: files.SortInsertionSize(display); break;
+            case 13: files.SortSelectionSize(display); break;
+            case 14: files.SortMergeSize(display); break;
+            case 15: files.SortHeapSize(display); break;
+            case 16: files.SortCountingSize(display); break;
+            case 17: files.SortQuickName(display); break;
+            case 18: files.SortRadixName(display); break;
+        }
+    }
+
+    void BrowseFiles() {
+        vector<File*> fileList = files.GetFilesVector();
+        if (fileList.empty()) {
+            cout << " [INFO] No files to browse.\n";
+            return;
+        }
+        
+        fileNavigator.BuildFromVector(fileList);
+        fileNavigator.Reset();
+        
+        while (true) {
+            ClearScreen();
+            PrintHeader("BROWSE FILES (Double Linked List)");
+            File* current = fileNavigator.GetCurrent();
+            if (current) {
+                current->DisplayDetailed();
+                cout << "\n Navigation:\n";
+                cout << " [N] Next File  [P] Previous File  [Q] Quit\n";
+                cout << " [V] View Version History\n";
+                PrintLine();
+                
+                char choice;
+                cout << " Enter choice: ";
+                cin >> choice;
+                cin.ignore();
+                choice = tolower(choice);
+                
+                switch(choice) {
+                    case 'n':
+                        if (fileNavigator.GetNext()) {
+                            cout << " Moved to next file.\n";
+                        } else {
+                            cout << " [INFO] Already at last file.\n";
+                        }
+                        break;
+                    case 'p':
+                        if (fileNavigator.GetPrev()) {
+                            cout << " Moved to previous file.\n";
+                        } else {
+                            cout << " [INFO] Already at first file.\n";
+                        }
+                        break;
+                    case 'v': {
+                        File* f = fileNavigator.GetCurrent();
+                        if (f) {
+                            PrintHeader("VERSION HISTORY (Linked List)");
+                            f->DisplayVersionHistory();
+                        }
+                        break;
+                    }
+                    case 'q':
+                        return;
+                    default:
+                        cout << " Invalid choice.\n";
+                }
+                cout << "\n (Press Enter to continue...)";
+                cin.get();
+            } else {
+                cout << " [ERROR] No files available.\n";
+                return;
+            }
+        }
+    }
+
+    void ViewFileVersions() {
+        int fileId = InputInt(" Enter File ID to view versions: ");
+        File* f = files.Search(fileId);
+        if (f) {
+            PrintHeader("VERSION HISTORY (Linked List)");
+            f->DisplayVersionHistory();
+            cout << "\n Total versions: " << f->GetVersionCount() << endl;
+            int ver = InputInt(" Enter version number to view (0 to skip): ", 0, f->GetVersionCount());
+            if (ver > 0) cout << " Content:  " << f->GetPreview(ver) << "\n";
+        } else {
+            cout << " [ERROR] File not found.\n";
+        }
+    }
+
+    // Saves newContent as the next version of the file
+    bool EditFile(int fileId, const string &newContent) {
+        File* f = files.Search(fileId);
+        if (!f) return false;
+        files.Update(fileId, [&newContent](File& edited) { edited.AddVersion(newContent); });
+        sysLog.Log("FileEdited", "File " + f->GetName() + " saved as version " + to_string(f->GetVersionCount()));
+        journal.Append(JournalRecord(JOP_EDIT_FILE).Str(owner).Int(id).Int(fileId).Str(newContent));
+        return true;
+    }
+
+    template <typename Fn>
+    void PageFiles(FileSortKey key, bool descending, size_t page, size_t pageSize, Fn fn) const {
+        files.Page(key, descending, page, pageSize, fn);
+    }
+
+    // Pages through the files sorted by a chosen key
+    void ListFiles() {
+        if (files.Size() == 0) { cout << " (Folder is empty)\n"; return; }
+        int key = InputInt(" Sort by (1. Name  2. Size  3. Priority): ", 1, 3) - 1;
+        bool descending = InputInt(" Order (1. Ascending  2. Descending): ", 1, 2) == 2;
+        size_t pages = (files.Size() + FILE_PAGE_SIZE - 1) / FILE_PAGE_SIZE;
+        size_t page = 0;
+        while (true) {
+            files.DisplayAll((FileSortKey)key, descending, page);
+            if (pages == 1) return;
+            cout << " [N] Next Page  [P] Previous Page  [Q] Quit\n";
+            string choice = InputString(" Enter choice: ");
+            char c = choice.empty() ? 'q' : tolower(choice[0]);
+            if (c == 'n' && page + 1 < pages) page++;
+            else if (c == 'p' && page > 0) page--;
+            else if (c == 'q') return;
+        }
+    }
+
+    // Changes a file's priority and re-stars or un-stars it to match
+    bool SetFilePriority(int fileId, int prio) {
+        File* f = files.Search(fileId);
+        if (!f || prio < 1 || prio > 10) return false;
+        files.Update(fileId, [prio](File& changed) { changed.SetPriority(prio); });
+        UpdateStarred(fileId, prio);
+        sysLog.Log("FilePriority", "File " + f->GetName() + " set to priority " + to_string(prio));
+        journal.Append(JournalRecord(JOP_SET_PRIORITY).Str(owner).Int(id).Int(fileId).Int(prio));
+        return true;
+    }
+
+    void SetFilePriority() {
+        int fileId = InputInt(" Enter File ID: ");
+        int prio = InputInt(" Enter new Priority (1-10): ", 1, 10);
+        if (SetFilePriority(fileId, prio)) {
+            cout << " [SUCCESS] Priority updated.\n";
+        } else {
+            cout << " [ERROR] File not found.\n";
+        }
+    }
+
+    /**
+     * @brief Prints the k highest-priority starred files. Costs O(k log k)
+     *        heap steps plus k hash lookups, however many files are starred.
+     */
+    void ShowStarredFiles(size_t k = STARRED_DISPLAY_LIMIT) {
+        if (starredFiles.Size() == 0) { cout << " No starred files.\n"; return; }
+        cout << " --- STARRED FILES (High Priority) ---\n";
+        starredFiles.TopK(k, [this](const FileMaxHeap::Entry& e) {
+            const File* f = files.Search(e.fileID);
+            if (f) cout << " [Prio " << e.priority << "] " << f->GetName() << "\n";
+        });
+        if (starredFiles.Size() > k) cout << " ... and " << starredFiles.Size() - k << " more\n";
+    }
+
+    // Visits the k highest-priority starred files, best first
+    template <typename Fn>
+    void ForEachStarred(size_t k, Fn fn) {
+        starredFiles.TopK(k, [this, &fn](const FileMaxHeap::Entry& e) {
+            File* f = files.Search(e.fileID);
+            if (f) fn(*f);
+        });
+    }
+
+    void EditFile() {
+        int fileId = InputInt(" Enter File ID to edit: ");
+        File* f = files.Search(fileId);
+        if (!f) {
+            cout << " [ERROR] File not found.\n";
+            return;
+        }
+        cout << " Current content: " << f->GetPreview(f->GetVersionCount()) << "\n";
+        string content = InputString(" Enter new content: ");
+        EditFile(fileId, content);
+        cout << " [SUCCESS] Saved version " << f->GetVersionCount() << ".\n";
+    }
+
+    void ShowMenu() {
+        while(true) {
+            PrintHeader("FOLDER: " + name);
+            cout << " 1. Create File\n";
+            cout << " 2. List All Files\n";
+            cout << " 3. Search File\n";
+            cout << " 4. Delete File\n";
+            cout << " 5. Trash Bin (Undo)\n";
+            cout << " 6. Recover Last Deleted\n";
+            cout << " 7. Recent Files\n";
+            cout << " 8. Starred/Priority Files\n";
+            cout << " 9. Browse Files (Double Linked List)\n";
+            cout << " 10. View File Version History (Linked List)\n";
+            cout << " --- SORTING ALGORITHMS ---\n";
+            cout << " 11. Sort: By Size (Bubble Sort)\n";
+            cout << " 12. Sort: By Size (Insertion Sort)\n";
+            cout << " 13. Sort: By Size (Selection Sort)\n";
+            cout << " 14. Sort: By Size (Merge Sort)\n";
+            cout << " 15. Sort: By Size (Heap Sort)\n";
+            cout << " 16. Sort: By Size (Counting Sort)\n";
+            cout << " 17. Sort: By Name (Quick Sort)\n";
+            cout << " 18. Sort: By Name (Radix Sort)\n";
+            cout << " ---\n";
+            cout << " 19. Edit File (Save New Version)\n";
+            cout << " 20. Upload File From Disk\n";
+            cout << " 21. Download File To Disk\n";
+            cout << " 22. Change File Priority\n";
+            cout << " 23. Back to Drive\n";
+            PrintLine();
+            
+            int ch = InputInt(" Select Action: ", 1, 23);
+            
+            switch(ch) {
+                case 1: CreateFile(); break;
+                case 2: ListFiles(); break;
+                case 3: SearchFile(); break;
+                case 4: DeleteFile(); break;
+                case 5: deletedFiles.Display(trashPolicy ? trashPolicy->Retention() : DEFAULT_TRASH_RETENTION); break;
+                case 6: RecoverFile(); break;
+                case 7: ShowRecentFiles(); break;
+                case 8: ShowStarredFiles(); break;
+                case 9: BrowseFiles(); break;
+                case 10: ViewFileVersions(); break;
+                case 11: case 12: case 13: case 14:
+                case 15: case 16: case 17: case 18: RunSort(ch); break;
+                case 19: EditFile(); break;
+                case 20: UploadFile(); break;
+                case 21: DownloadFile(); break;
+                case 22: SetFilePriority(); break;
+                case 23: return;
+            }
+            CommitJournal();  // The action is only reported done once it is durable
+            
+            cout << "\n (Press Enter to continue...)";
+            cin.get(); 
+        }
+    }
+
+    File* GetFileById(int fid) { return files.Search(fid); }
+};
+
+/**
+ * @class BPlusTreeFolders
+ * @brief B+-tree index from folder ID to a stable Folder handle.
+ *
+ * Each folder is allocated once and never moves, so a Folder* stays valid
+ * until that folder is removed. Nodes live in two pools and point at each
+ * other by index. An inner node is two cache lines: the count and 15 keys
+ * in the first, 16 child indexes in the second. A leaf keeps its keys in
+ * its first line and the handles after them, and leaves are chained in ID
+ * order for range scans. Folder IDs are handed out in ascending order, so a
+ * split at the right edge keeps the left node full instead of half full.
+ * With 100k folders a lookup reads about five nodes, against ~17 dependent
+ * loads down an AVL tree.
+ */
+class BPlusTreeFolders {
+    friend class DriveSnapshot;
+private:
+    static const int INNER_KEYS = 15;
+    static const int LEAF_KEYS = 15;
+    static const int MIN_KEYS = 7;       // Every node but the root keeps at least this many after a removal
+    static const int MAX_HEIGHT = 24;
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct alignas(64) Inner {
+        int32_t count;                    // Keys; there are count + 1 children
+        int32_t keys[INNER_KEYS];         // Child i holds IDs in [keys[i - 1], keys[i])
+        uint32_t child[INNER_KEYS + 1];
+    };
+
+    struct alignas(64) Leaf {
+        int32_t count;
+        int32_t keys[LEAF_KEYS];
+        Folder* folders[LEAF_KEYS];
+        uint32_t prev, next;
+    };
+
+    static_assert(sizeof(Inner) == 128, "inner node should fill exactly two cache lines");
+
+    struct Step {
+        uint32_t node;
+        int slot;
+    };
+
+    vector<Inner> inners;
+    vector<Leaf> leaves;
+    vector<uint32_t> freeInners, freeLeaves;
+    uint32_t root;       // A leaf when height is 0
+    int height;          // Inner levels above the leaves
+    uint32_t firstLeaf;
+    size_t count;
+
+    // Child that may hold id: the number of keys <= id. Branch-free so the compiler can vectorise it.
+    static int ChildSlot(const Inner& n, int id) {
+        int slot = 0;
+        for (int i = 0; i < n.count; i++) slot += n.keys[i] <= id;
+        return slot;
+    }
+
+    // First slot whose key is >= id
+    static int LeafSlot(const Leaf& n, int id) {
+        int slot = 0;
+        for (int i = 0; i < n.count; i++) slot += n.keys[i] < id;
+        return slot;
+    }
+
+    uint32_t NewLeaf() {
+        uint32_t i;
+        if (!freeLeaves.empty()) {
+            i = freeLeaves.back();
+            freeLeaves.pop_back();
+        } else {
+            i = leaves.size();
+            leaves.emplace_back();
+        }
+        leaves[i].count = 0;
+        leaves[i].prev = leaves[i].next = NONE;
+        return i;
+    }
+
+    uint32_t NewInner() {
+        uint32_t i;
+        if (!freeInners.empty()) {
+            i = freeInners.back();
+            freeInners.pop_back();
+        } else {
+            i = inners.size();
+            inners.emplace_back();
+        }
+        inners[i].count = 0;
+        return i;
+    }
+
+    // Walks from the root to the leaf that holds (or would hold) id, recording the path
+    uint32_t Descend(int id, Step* path) const {
+        uint32_t n = root;
+        for (int level = 0; level < height; level++) {
+            int slot = ChildSlot(inners[n], id);
+            if (path) path[level] = {n, slot};
+            n = inners[n].child[slot];
+        }
+        return n;
+    }
+
+    /*
+     * Adds key with rightChild just after path[level]'s slot, splitting full
+     * nodes upward. At the right edge a split leaves the left node full.
+     */
+    void InsertSeparator(Step* path, int level, int key, uint32_t rightChild, bool rightEdge) {
+        for (; level >= 0; level--) {
+            uint32_t ni = path[level].node;
+            int slot = path[level].slot;
+            Inner* n = &inners[ni];
+            if (n->count < INNER_KEYS) {
+                for (int i = n->count; i > slot; i--) {
+                    n->keys[i] = n->keys[i - 1];
+                    n->child[i + 1] = n->child[i];
+                }
+                n->keys[slot] = key;
+                n->child[slot + 1] = rightChild;
+                n->count++;
+                return;
+            }
+
+            int keys[INNER_KEYS + 1];
+            uint32_t kids[INNER_KEYS + 2];
+            for (int i = 0, k = 0; i <= INNER_KEYS; i++) keys[i] = i == slot ? key : n->keys[k++];
+            for (int i = 0, k = 0; i <= INNER_KEYS + 1; i++) kids[i] = i == slot + 1 ? rightChild : n->child[k++];
+
+            int leftKeys = rightEdge ? INNER_KEYS - 1 : INNER_KEYS / 2;
+            uint32_t ri = NewInner();
+            n = &inners[ni];
+            Inner* r = &inners[ri];
+            n->count = leftKeys;
+            copy(keys, keys + leftKeys, n->keys);
+            copy(kids, kids + leftKeys + 1, n->child);
+            r->count = INNER_KEYS - leftKeys;
+            copy(keys + leftKeys + 1, keys + INNER_KEYS + 1, r->keys);
+            copy(kids + leftKeys + 1, kids + INNER_KEYS + 2, r->child);
+            key = keys[leftKeys];
+            rightChild = ri;
+        }
+
+        uint32_t ri = NewInner();
+        Inner& r = inners[ri];
+        r.count = 1;
+        r.keys[0] = key;
+        r.child[0] = root;
+        r.child[1] = rightChild;
+        root = ri;
+        height++;
+    }
+
+    // Removes separator sep and the child to its right from an inner node
+    static void RemoveSeparator(Inner& p, int sep) {
+        for (int i = sep; i + 1 < p.count; i++) {
+            p.keys[i] = p.keys[i + 1];
+            p.child[i + 1] = p.child[i + 2];
+        }
+        p.count--;
+    }
+
+    // Refills a leaf that fell below MIN_KEYS from a sibling, or merges the two
+    void FixLeaf(Step* path, uint32_t li) {
+        if (height == 0 || leaves[li].count >= MIN_KEYS) return;
+        Inner& p = inners[path[height - 1].node];
+        int s = path[height - 1].slot;
+        int sep = s > 0 ? s - 1 : 0;
+        Leaf& l = leaves[p.child[sep]];
+        Leaf& r = leaves[p.child[sep + 1]];
+
+        if (l.count + r.count <= LEAF_KEYS) {
+            copy(r.keys, r.keys + r.count, l.keys + l.count);
+            copy(r.folders, r.folders + r.count, l.folders + l.count);
+            l.count += r.count;
+            l.next = r.next;
+            if (r.next != NONE) leaves[r.next].prev = r.prev;
+            r.count = 0;
+            freeLeaves.push_back(p.child[sep + 1]);
+            RemoveSeparator(p, sep);
+            FixInner(path, height - 1);
+            return;
+        }
+
+        // Even the two out; the separator becomes the right leaf's new first key
+        int total = l.count + r.count, leftCount = total / 2;
+        int keys[2 * LEAF_KEYS];
+        Folder* folders[2 * LEAF_KEYS];
+        copy(l.keys, l.keys + l.count, keys);
+        copy(r.keys, r.keys + r.count, keys + l.count);
+        copy(l.folders, l.folders + l.count, folders);
+        copy(r.folders, r.folders + r.count, folders + l.count);
+        l.count = leftCount;
+        r.count = total - leftCount;
+        copy(keys, keys + leftCount, l.keys);
+        copy(folders, folders + leftCount, l.folders);
+        copy(keys + leftCount, keys + total, r.keys);
+        copy(folders + leftCount, folders + total, r.folders);
+        p.keys[sep] = r.keys[0];
+    }
+
+    void FixInner(Step* path, int level) {
+        for (; level >= 0; level--) {
+            uint32_t ni = path[level].node;
+            if (level == 0) {
+                if (inners[ni].count == 0) {  // The root lost its last key: its only child takes over
+                    root = inners[ni].child[0];
+                    height--;
+                    freeInners.push_back(ni);
+                }
+                return;
+            }
+            if (inners[ni].count >= MIN_KEYS) return;
+
+            Inner& p = inners[path[level - 1].node];
+            int s = path[level - 1].slot;
+            int sep = s > 0 ? s - 1 : 0;
+            Inner& l = inners[p.child[sep]];
+            Inner& r = inners[p.child[sep + 1]];
+
+            if (l.count + r.count + 1 <= INNER_KEYS) {
+                l.keys[l.count] = p.keys[sep];
+                copy(r.keys, r.keys + r.count, l.keys + l.count + 1);
+                copy(r.child, r.child + r.count + 1, l.child + l.count + 1);
+                l.count += r.count + 1;
+                freeInners.push_back(p.child[sep + 1]);
+                RemoveSeparator(p, sep);
+                continue;
+            }
+
+            // Rotate through the parent: pool the keys and the separator, then split them evenly
+            int total = l.count + r.count + 1, leftKeys = total / 2;
+            int keys[2 * INNER_KEYS + 1];
+            uint32_t kids[2 * INNER_KEYS + 2];
+            copy(l.keys, l.keys + l.count, keys);
+            keys[l.count] = p.keys[sep];
+            copy(r.keys, r.keys + r.count, keys + l.count + 1);
+            copy(l.child, l.child + l.count + 1, kids);
+            copy(r.child, r.child + r.count + 1, kids + l.count + 1);
+            l.count = leftKeys;
+            copy(keys, keys + leftKeys, l.keys);
+            copy(kids, kids + leftKeys + 1, l.child);
+            r.count = total - leftKeys - 1;
+            copy(keys + leftKeys + 1, keys + total, r.keys);
+            copy(kids + leftKeys + 1, kids + total + 1, r.child);
+            p.keys[sep] = keys[leftKeys];
+            return;
+        }
+    }
+
+    // Sizes of the groups n items are packed into, all full except that the
+    // last two are evened out so neither has fewer than minSize
+    static vector<int> Groups(size_t n, int cap, int minSize) {
+        vector<int> sizes(n / cap, cap);
+        int rest = n % cap;
+        if (rest) {
+            if (!sizes.empty() && rest < minSize) {
+                sizes.back() -= minSize - rest;
+                rest = minSize;
+            }
+            sizes.push_back(rest);
+        }
+        return sizes;
+    }
+
+    // Gives every live leaf copies of the folders it points at
+    void CloneFolders() {
+        for (uint32_t li = firstLeaf; li != NONE; li = leaves[li].next) {
+            Leaf& leaf = leaves[li];
+            for (int i = 0; i < leaf.count; i++) leaf.folders[i] = new Folder(*leaf.folders[i]);
+        }
+    }
+
+    // Forgets every node; the folders themselves are not freed
+    void Reset() {
+        inners.clear();
+        leaves.clear();
+        freeInners.clear();
+        freeLeaves.clear();
+        root = firstLeaf = NONE;
+        height = 0;
+        count = 0;
+    }
+
+    void DeleteFolders() {
+        ForEach([](Folder& f) { delete &f; });
+    }
+
+    bool Insert(Folder* f) {
+        int id = f->GetID();
+        if (root == NONE) root = firstLeaf = NewLeaf();
+
+        Step path[MAX_HEIGHT];
+        uint32_t li = Descend(id, path);
+        Leaf* leaf = &leaves[li];
+        int slot = LeafSlot(*leaf, id);
+        if (slot < leaf->count && leaf->keys[slot] == id) return false;
+        count++;
+
+        if (leaf->count == LEAF_KEYS) {
+            bool rightEdge = slot == LEAF_KEYS && leaf->next == NONE;
+            int keep = rightEdge ? LEAF_KEYS : (LEAF_KEYS + 1) / 2;
+            uint32_t ri = NewLeaf();
+            leaf = &leaves[li];
+            Leaf* right = &leaves[ri];
+            right->count = LEAF_KEYS - keep;
+            copy(leaf->keys + keep, leaf->keys + LEAF_KEYS, right->keys);
+            copy(leaf->folders + keep, leaf->folders + LEAF_KEYS, right->folders);
+            leaf->count = keep;
+            right->prev = li;
+            right->next = leaf->next;
+            if (leaf->next != NONE) leaves[leaf->next].prev = ri;
+            leaf->next = ri;
+
+            if (rightEdge || slot > keep) {
+                leaf = right;
+                slot -= keep;
+            }
+            for (int i = leaf->count; i > slot; i--) {
+                leaf->keys[i] = leaf->keys[i - 1];
+                leaf->folders[i] = leaf->folders[i - 1];
+            }
+            leaf->keys[slot] = id;
+            leaf->folders[slot] = f;
+            leaf->count++;
+            InsertSeparator(path, height - 1, right->keys[0], ri, rightEdge);
+            return true;
+        }
+
+        for (int i = leaf->count; i > slot; i--) {
+            leaf->keys[i] = leaf->keys[i - 1];
+            leaf->folders[i] = leaf->folders[i - 1];
+        }
+        leaf->keys[slot] = id;
+        leaf->folders[slot] = f;
+        leaf->count++;
+        return true;
+    }
+
+    // Unlinks a folder and hands its handle back to the caller
+    Folder* Erase(int id) {
+        if (root == NONE) return nullptr;
+        Step path[MAX_HEIGHT];
+        uint32_t li = Descend(id, path);
+        Leaf& leaf = leaves[li];
+        int slot = LeafSlot(leaf, id);
+        if (slot == leaf.count || leaf.keys[slot] != id) return nullptr;
+
+        Folder* f = leaf.folders[slot];
+        for (int i = slot; i + 1 < leaf.count; i++) {
+            leaf.keys[i] = leaf.keys[i + 1];
+            leaf.folders[i] = leaf.folders[i + 1];
+        }
+        leaf.count--;
+        if (--count == 0) Reset();
+        else FixLeaf(path, li);
+        return f;
+    }
+
+public:
+    BPlusTreeFolders() : root(NONE), height(0), firstLeaf(NONE), count(0) {}
+
+    ~BPlusTreeFolders() { DeleteFolders(); }
+
+    // Copies share no folders: the node pools are copied flat and every folder is cloned
+    BPlusTreeFolders(const BPlusTreeFolders& other)
+        : inners(other.inners), leaves(other.leaves), freeInners(other.freeInners), freeLeaves(other.freeLeaves),
+          root(other.root), height(other.height), firstLeaf(other.firstLeaf), count(other.count) {
+        CloneFolders();
+    }
+
+    BPlusTreeFolders& operator=(const BPlusTreeFolders& other) {
+        if (this != &other) {
+            BPlusTreeFolders copy(other);
+            *this = move(copy);
+        }
+        return *this;
+    }
+
+    BPlusTreeFolders(BPlusTreeFolders&& other) noexcept
+        : inners(move(other.inners)), leaves(move(other.leaves)), freeInners(move(other.freeInners)),
+          freeLeaves(move(other.freeLeaves)), root(other.root), height(other.height),
+          firstLeaf(other.firstLeaf), count(other.count) {
+        other.Reset();
+    }
+
+    BPlusTreeFolders& operator=(BPlusTreeFolders&& other) noexcept {
+        if (this != &other) {
+            DeleteFolders();
+            inners = move(other.inners);
+            leaves = move(other.leaves);
+            freeInners = move(other.freeInners);
+            freeLeaves = move(other.freeLeaves);
+            root = other.root;
+            height = other.height;
+            firstLeaf = other.firstLeaf;
+            count = other.count;
+            other.Reset();
+        }
+        return *this;
+    }
+
+    /**
+     * @brief  Takes ownership of a folder.
+     * @return Its handle, or nullptr if the ID is already taken.
+     */
+    Folder* AddFolder(Folder&& f) {
+        if (GetFolder(f.GetID())) {
+            cout << " [WARNING] Folder with ID " << f.GetID() << " already exists. Skipping.\n";
+            return nullptr;
+        }
+        Folder* handle = new Folder(move(f));
+        Insert(handle);
+        return handle;
+    }
+
+    /**
+     * @brief  Builds the tree bottom-up from folders in strictly ascending ID
+     *         order, packing every node full. Takes ownership on success.
+     * @return false if the tree is not empty or the IDs are out of order.
+     */
+    bool BulkLoad(const vector<Folder*>& sorted) {
+        if (count) return false;
+        for (size_t i = 1; i < sorted.size(); i++) {
+            if (sorted[i - 1]->GetID() >= sorted[i]->GetID()) return false;
+        }
+        if (sorted.empty()) return true;
+
+        vector<uint32_t> level;   // Nodes of the level being built, left to right
+        vector<int> lows;         // Smallest ID under each of them
+        size_t next = 0;
+        uint32_t prev = NONE;
+        for (int size : Groups(sorted.size(), LEAF_KEYS, MIN_KEYS)) {
+            uint32_t li = NewLeaf();
+            Leaf& leaf = leaves[li];
+            leaf.count = size;
+            for (int i = 0; i < size; i++, next++) {
+                leaf.keys[i] = sorted[next]->GetID();
+                leaf.folders[i] = sorted[next];
+            }
+            leaf.prev = prev;
+            if (prev != NONE) leaves[prev].next = li;
+            prev = li;
+            level.push_back(li);
+            lows.push_back(leaf.keys[0]);
+        }
+        firstLeaf = level[0];
+        height = 0;
+
+        while (level.size() > 1) {
+            vector<uint32_t> parents;
+            vector<int> parentLows;
+            size_t c = 0;
+            for (int size : Groups(level.size(), INNER_KEYS + 1, MIN_KEYS + 1)) {
+                uint32_t ni = NewInner();
+                Inner& n = inners[ni];
+                n.count = size - 1;
+                for (int i = 0; i < size; i++, c++) {
+                    n.child[i] = level[c];
+                    if (i > 0) n.keys[i - 1] = lows[c];
+                }
+                parents.push_back(ni);
+                parentLows.push_back(lows[c - size]);
+            }
+            level.swap(parents);
+            lows.swap(parentLows);
+            height++;
+        }
+        root = level[0];
+        count = sorted.size();
+        return true;
+    }
+
+    Folder* GetFolder(int id) const {
+        if (root == NONE) return nullptr;
+        const Leaf& leaf = leaves[Descend(id, nullptr)];
+        int slot = LeafSlot(leaf, id);
+        return slot < leaf.count && leaf.keys[slot] == id ? leaf.folders[slot] : nullptr;
+    }
+
+    // Deletes a folder and everything in it; other folders' handles stay valid
+    bool RemoveFolder(int id) {
+        Folder* f = Erase(id);
+        delete f;
+        return f != nullptr;
+    }
+
+    size_t Size() const { return count; }
+
+    // Visits every folder in ID order
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        for (uint32_t li = firstLeaf; li != NONE; li = leaves[li].next) {
+            const Leaf& leaf = leaves[li];
+            for (int i = 0; i < leaf.count; i++) fn(*leaf.folders[i]);
+        }
+    }
+
+    // Visits the folders with lo <= ID <= hi in ID order
+    template <typename Fn>
+    void ForEachInRange(int lo, int hi, Fn fn) const {
+        if (root == NONE || lo > hi) return;
+        uint32_t li = Descend(lo, nullptr);
+        for (int i = LeafSlot(leaves[li], lo); li != NONE; li = leaves[li].next, i = 0) {
+            const Leaf& leaf = leaves[li];
+            for (; i < leaf.count; i++) {
+                if (leaf.keys[i] > hi) return;
+                fn(*leaf.folders[i]);
+            }
+        }
+    }
+
+    void DisplayAll() const {
+        if (!count) {
+            cout << " No folders yet.\n";
+            return;
+        }
+        cout << " --- FOLDER LIST (B+ Tree, " << count << " folders) ---\n";
+        ForEach([](const Folder& f) {
+            cout << " [ID: " << setw(3) << f.GetID() << "] " << f.GetName() << "\n";
+        });
+    }
+};
+
+const int AUTOCOMPLETE_LIMIT = 10;  // Completions cached per trie node
+
+/**
+ * @class TrieUsers
+ * @brief Path-compressed radix trie of usernames over the full byte alphabet.
+ *
+ * Each edge carries a whole run of bytes, so a chain of single-child nodes
+ * becomes one node. Every node caches the AUTOCOMPLETE_LIMIT best names in
+ * its subtree (highest score first, then by name), so a completion walks
+ * the prefix and copies one list: O(prefix + K). A new or rising name is
+ * slotted into the lists on its path; a falling one makes the full lists
+ * it was in rebuild from their children. Nodes live in a pool and are
+ * freed with the trie.
+ */
+class TrieUsers {
+public:
+    struct Suggestion {
+        string name;
+        int64_t score;
+    };
+
+private:
+    struct Node {
+        string label;               // Bytes on the edge into this node
+        vector<uint32_t> children;  // Sorted by the first byte of their label
+        int32_t word;               // Index into words, or -1
+        vector<uint32_t> top;       // Best words in this subtree, best first
+    };
+
+    vector<Node> nodes;   // nodes[0] is the root
+    vector<Suggestion> words;
+    vector<uint32_t> freeNodes, freeWords;
+    vector<uint32_t> scratch;
+
+    bool Better(uint32_t a, uint32_t b) const {
+        if (words[a].score != words[b].score) return words[a].score > words[b].score;
+        return words[a].name < words[b].name;
+    }
+
+    // Child of n whose label starts with byte c, or -1
+    long FindChild(uint32_t n, unsigned char c) const {
+        const vector<uint32_t>& kids = nodes[n].children;
+        auto it = lower_bound(kids.begin(), kids.end(), c, [this](uint32_t k, unsigned char b) {
+            return (unsigned char)nodes[k].label[0] < b;
+        });
+        return it != kids.end() && (unsigned char)nodes[*it].label[0] == c ? (long)*it : -1;
+    }
+
+    void AddChild(uint32_t n, uint32_t child) {
+        vector<uint32_t>& kids = nodes[n].children;
+        unsigned char c = nodes[child].label[0];
+        auto it = lower_bound(kids.begin(), kids.end(), c, [this](uint32_t k, unsigned char b) {
+            return (unsigned char)nodes[k].label[0] < b;
+        });
+        kids.insert(it, child);
+    }
+
+    uint32_t NewNode(const string& label) {
+        if (!freeNodes.empty()) {
+            uint32_t n = freeNodes.back();
+            freeNodes.pop_back();
+            nodes[n] = Node{label, {}, -1, {}};
+            return n;
+        }
+        nodes.push_back(Node{label, {}, -1, {}});
+        return nodes.size() - 1;
+    }
+
+    /**
+     * @brief  Walks key from the root.
+     * @return The node that spells key exactly, or -1. path gets every node
+     *         visited, root first.
+     */
+    long Find(const string& key, vector<uint32_t>* path) const {
+        uint32_t n = 0;
+        size_t pos = 0;
+        if (path) path->push_back(0);
+        while (pos < key.size()) {
+            long c = FindChild(n, key[pos]);
+            if (c < 0) return -1;
+            const string& label = nodes[c].label;
+            if (key.compare(pos, label.size(), label) != 0) return -1;
+            pos += label.size();
+            n = c;
+            if (path) path->push_back(n);
+        }
+        return n;
+    }
+
+    // Recomputes one node's list from its own word and its children's lists
+    void Rebuild(uint32_t n) {
+        vector<uint32_t>& candidates = scratch;
+        candidates.clear();
+        if (nodes[n].word >= 0) candidates.push_back(nodes[n].word);
+        for (uint32_t c : nodes[n].children) {
+            const vector<uint32_t>& t = nodes[c].top;
+            candidates.insert(candidates.end(), t.begin(), t.end());
+        }
+        size_t k = min<size_t>(AUTOCOMPLETE_LIMIT, candidates.size());
+        partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(),
+                     [this](uint32_t a, uint32_t b) { return Better(a, b); });
+        nodes[n].top.assign(candidates.begin(), candidates.begin() + k);
+    }
+
+    /*
+     * Word w just gained score (or was added); path is root-first and ends at
+     * its node. Only lists w now qualifies for change, and a node's list is
+     * drawn from its ancestors' candidates, so the walk stops at the first
+     * list w does not make.
+     */
+    void Promote(const vector<uint32_t>& path, uint32_t w) {
+        for (size_t i = path.size(); i-- > 0;) {
+            vector<uint32_t>& top = nodes[path[i]].top;
+            top.erase(remove(top.begin(), top.end(), w), top.end());
+            auto at = lower_bound(top.begin(), top.end(), w, [this](uint32_t a, uint32_t b) { return Better(a, b); });
+            if (at - top.begin() >= AUTOCOMPLETE_LIMIT) return;
+            top.insert(at, w);
+            if (top.size() > (size_t)AUTOCOMPLETE_LIMIT) top.pop_back();
+        }
+    }
+
+    // Word w lost score. A full list holding it may now owe its place to a
+    // word it never cached, so those lists are rebuilt from their children.
+    void Demote(const vector<uint32_t>& path, uint32_t w) {
+        for (size_t i = path.size(); i-- > 0;) {
+            vector<uint32_t>& top = nodes[path[i]].top;
+            auto it = find(top.begin(), top.end(), w);
+            if (it == top.end()) return;
+            if (top.size() < (size_t)AUTOCOMPLETE_LIMIT) {
+                top.erase(it);
+                top.insert(lower_bound(top.begin(), top.end(), w, [this](uint32_t a, uint32_t b) { return Better(a, b); }), w);
+            } else {
+                Rebuild(path[i]);
+            }
+        }
+    }
+
+public:
+    TrieUsers() { NewNode(""); }
+
+    /**
+     * @brief  Adds a name with an initial score.
+     * @return false if the name is already present.
+     */
+    bool Insert(const string& key, int64_t score = 0) {
+        vector<uint32_t> path(1, 0);
+        uint32_t n = 0;
+        size_t pos = 0;
+        while (pos < key.size()) {
+            long c = FindChild(n, key[pos]);
+            if (c < 0) {
+                uint32_t leaf = NewNode(key.substr(pos));
+                AddChild(n, leaf);
+                n = leaf;
+                path.push_back(n);
+                break;
+            }
+            // Length of the common run of the edge and the rest of the key
+            const string& label = nodes[c].label;
+            size_t common = 0;
+            while (common < label.size() && pos + common < key.size() && label[common] == key[pos + common]) common++;
+            if (common < label.size()) {
+                // Split the edge: a new node takes the common run and the old child hangs below it
+                uint32_t mid = NewNode(nodes[c].label.substr(0, common));
+                nodes[c].label.erase(0, common);
+                nodes[mid].children.push_back(c);
+                nodes[mid].top = nodes[c].top;
+                replace(nodes[n].children.begin(), nodes[n].children.end(), (uint32_t)c, mid);
+                c = mid;
+            }
+            pos += common;
+            n = c;
+            path.push_back(n);
+        }
+        if (nodes[n].word >= 0) return false;
+
+        if (!freeWords.empty()) {
+            nodes[n].word = freeWords.back();
+            freeWords.pop_back();
+            words[nodes[n].word] = {key, score};
+        } else {
+            nodes[n].word = words.size();
+            words.push_back({key, score});
+        }
+        Promote(path, nodes[n].word);
+        return true;
+    }
+
+    bool Search(const string& key) const {
+        long n = Find(key, nullptr);
+        return n >= 0 && nodes[n].word >= 0;
+    }
+
+    // Re-ranks a name, e.g. when its friend count changes
+    bool SetScore(const string& key, int64_t score) {
+        vector<uint32_t> path;
+        long n = Find(key, &path);
+        if (n < 0 || nodes[n].word < 0) return false;
+        uint32_t w = nodes[n].word;
+        int64_t old = words[w].score;
+        words[w].score = score;
+        if (score > old) Promote(path, w);
+        else if (score < old) Demote(path, w);
+        return true;
+    }
+
+    /**
+     * @brief  The best completions of prefix (which may be a full name).
+     * @return At most min(k, AUTOCOMPLETE_LIMIT) names, highest score first.
+     */
+    vector<Suggestion> AutoComplete(const string& prefix, size_t k = AUTOCOMPLETE_LIMIT) const {
+        vector<Suggestion> out;
+        uint32_t n = 0;
+        size_t pos = 0;
+        while (pos < prefix.size()) {
+            long c = FindChild(n, prefix[pos]);
+            if (c < 0) return out;
+            const string& label = nodes[c].label;
+            size_t len = min(label.size(), prefix.size() - pos);
+            if (prefix.compare(pos, len, label, 0, len) != 0) return out;  // The prefix may end mid-edge
+            pos += len;
+            n = c;
+        }
+        const vector<uint32_t>& top = nodes[n].top;
+        for (size_t i = 0; i < top.size() && i < k; i++) out.push_back(words[top[i]]);
+        return out;
+    }
+
+    /**
+     * @brief  Forgets a name. Lists that held it are rebuilt, and nodes left
+     *         with neither a name nor children are unlinked for reuse.
+     * @return false if the name is not present.
+     */
+    bool Remove(const string& key) {
+        vector<uint32_t> path;
+        long n = Find(key, &path);
+        if (n < 0 || nodes[n].word < 0) return false;
+        uint32_t w = nodes[n].word;
+        nodes[n].word = -1;
+        for (size_t i = path.size(); i-- > 0;) {
+            const vector<uint32_t>& top = nodes[path[i]].top;
+            if (find(top.begin(), top.end(), w) == top.end()) break;
+            Rebuild(path[i]);
+        }
+        for (size_t i = path.size() - 1; i > 0; i--) {
+            Node& node = nodes[path[i]];
+            if (node.word >= 0 || !node.children.empty()) break;
+            vector<uint32_t>& kids = nodes[path[i - 1]].children;
+            kids.erase(find(kids.begin(), kids.end(), path[i]));
+            node = Node{"", {}, -1, {}};
+            freeNodes.push_back(path[i]);
+        }
+        words[w] = {"", 0};
+        freeWords.push_back(w);
+        return true;
+    }
+
+    size_t Size() const { return words.size() - freeWords.size(); }
+};
+
+class User {
+    friend class DriveSnapshot;
+    friend class UserDirectory;
+private:
+    uint32_t id;               // Stable; assigned by the UserDirectory
+    string username;
+    string password;
+    string securityQ;
+    string securityA;
+    BPlusTreeFolders myFolders;
+    int folderCounter;
+    CircularNotificationQueue notifications;  // Changed from vector to Circular Linked List
+    TrashPolicy trash;
+
+public:
+    User() : id(UINT32_MAX), folderCounter(1) {}
+
+    void Setup(string u, string p, string sq, string sa) {
+        username = u;
+        password = p;
+        securityQ = sq;
+        securityA = sa;
+    }
+
+    bool CheckPassword(string p) { return password == p; }
+    string GetName() const { return username; }
+    uint32_t GetID() const { return id; }
+    string GetSecQ() const { return securityQ; }
+    bool CheckSecA(string a) { return securityA == a; }
+    void SetPassword(string p) { password = p; }
+
+    /**
+     * @brief  Creates a folder without any prompts.
+     * @return ID of the new folder.
+     */
+    int CreateFolder(const string &fname) {
+        Folder f;
+        f.SetValues(fname, folderCounter, username);
+        f.SetTrashPolicy(&trash);
+        myFolders.AddFolder(move(f));
+        sysLog.Log("FolderCreate", username + " created folder " + fname);
+        journal.Append(JournalRecord(JOP_CREATE_FOLDER).Str(username).Int(folderCounter).Str(fname));
+        return folderCounter++;
+    }
+
+    void CreateFolder() {
+        string fname = InputString(" Enter new folder name: ");
+        if (fname.empty()) {
+            cout << " [ERROR] Folder name cannot be empty.\n";
+            return;
+        }
+        
+        int newID = CreateFolder(fname);
+        cout << " [SUCCESS] Folder '" << fname << "' created (ID: " << newID << ").\n";
+    }
+
+    /**
+     * @brief  Deletes a folder with its files and trash. IDs are never reused.
+     * @return false if the folder does not exist.
+     */
+    bool DeleteFolder(int folderID) {
+        Folder* f = myFolders.GetFolder(folderID);
+        if (!f) return false;
+        string fname = f->GetName();
+        myFolders.RemoveFolder(folderID);
+        sysLog.Log("FolderDelete", username + " deleted folder " + fname);
+        journal.Append(JournalRecord(JOP_DELETE_FOLDER).Str(username).Int(folderID));
+        return true;
+    }
+
+    void DeleteFolder() {
+        myFolders.DisplayAll();
+        int fid = InputInt(" Enter Folder ID to delete: ");
+        Folder* f = myFolders.GetFolder(fid);
+        if (!f) {
+            cout << " [ERROR] Invalid Folder ID.\n";
+            return;
+        }
+        string fname = f->GetName();
+        string confirm = InputString(" Delete '" + fname + "' and all its files? (y/n): ");
+        if (confirm != "y" && confirm != "Y") {
+            cout << " [INFO] Nothing deleted.\n";
+            return;
+        }
+        DeleteFolder(fid);
+        cout << " [SUCCESS] Folder '" << fname << "' deleted.\n";
+    }
+
+    void OpenFolder() {
+        myFolders.DisplayAll();
+        int fid = InputInt(" Enter Folder ID to open: ");
+        Folder* f = myFolders.GetFolder(fid);
+        if(f) {
+            f->ShowMenu();
+        } else {
+            cout << " [ERROR] Invalid Folder ID.\n";
+        }
+    }
+
+    void AddNotification(string msg) {
+        notifications.AddNotification("[" + CurrentTimestamp() + "] " + msg);
+    }
+
+    void ShowNotifications() {
+        PrintHeader("NOTIFICATIONS");
+        notifications.DisplayAll();
+        PrintLine();
+    }
+    
+    /**
+     * @brief  Changes how many files each folder's trash keeps and for how
+     *         many seconds; trashes over the new capacity lose their oldest files.
+     * @return false if the limits are out of range.
+     */
+    bool SetTrashLimits(int capacity, int64_t retention) {
+        if (!TrashPolicy::ValidLimits(capacity, retention)) return false;
+        int64_t now = time(nullptr);
+        trash.Reset(capacity, retention, now);
+        myFolders.ForEach([this](Folder& f) { f.SetTrashPolicy(&trash); });
+        ExpireTrash(now);
+        sysLog.Log("TrashLimits", username + " set trash to " + to_string(capacity) + " files, " +
+                   to_string(retention) + "s");
+        journal.Append(JournalRecord(JOP_TRASH_LIMITS).Str(username).Int(capacity).Int(retention));
+        return true;
+    }
+
+    void SetTrashLimits() {
+        PrintHeader("TRASH SETTINGS");
+        cout << " Current: " << trash.Capacity() << " files per folder, kept "
+             << trash.Retention() / 86400 << " day(s).\n";
+        int capacity = InputInt(" Files to keep per folder: ", 1, MAX_TRASH_CAPACITY);
+        int days = InputInt(" Days before deleted files expire: ", 1, 3650);
+        if (SetTrashLimits(capacity, days * 86400LL)) {
+            cout << " [SUCCESS] Trash settings updated.\n";
+        } else {
+            cout << " [ERROR] Invalid trash settings.\n";
+        }
+    }
+
+    /**
+     * @brief  Fires the trash timers that are due; only folders whose oldest
+     *         trashed file may have expired are visited.
+     * @return How many files expired.
+     */
+    size_t ExpireTrash(int64_t now) {
+        return trash.Advance(now, [this, now](int folderID) -> size_t {
+            Folder* f = myFolders.GetFolder(folderID);
+            return f ? f->ExpireTrash(now) : 0;
+        });
+    }
+
+    struct RecentHit {
+        Folder* folder;
+        File* file;
+        int64_t accessedAt;
+    };
+
+    /**
+     * @brief  Merges the recent lists of every folder, newest first.
+     * @return At most limit accesses. Each folder's list is already ordered,
+     *         so a heap of one cursor per folder yields them in O(limit log F).
+     */
+    vector<RecentHit> RecentAcrossFolders(size_t limit) {
+        struct Cursor {
+            int64_t accessedAt;
+            Folder* folder;
+            int slot;
+            bool operator<(const Cursor& o) const { return accessedAt < o.accessedAt; }
+        };
+        priority_queue<Cursor> heads;
+        myFolders.ForEach([&heads](Folder& f) {
+            int s = f.GetRecentFiles().First();
+            if (s != -1) heads.push({f.GetRecentFiles().At(s).accessedAt, &f, s});
+        });
+
+        vector<RecentHit> hits;
+        while (!heads.empty() && hits.size() < limit) {
+            Cursor c = heads.top();
+            heads.pop();
+            const RecentFiles& recent = c.folder->GetRecentFiles();
+            File* f = c.folder->GetFileById(recent.At(c.slot).fileID);
+            if (f) hits.push_back({c.folder, f, c.accessedAt});
+            int next = recent.After(c.slot);
+            if (next != -1) heads.push({recent.At(next).accessedAt, c.folder, next});
+        }
+        return hits;
+    }
+
+    void ShowRecentFiles() {
+        PrintHeader("RECENT FILES (ALL FOLDERS)");
+        vector<RecentHit> hits = RecentAcrossFolders(MAX_RECENT_FILES);
+        if (hits.empty()) cout << " (No recent files)\n";
+        for (size_t i = 0; i < hits.size(); i++) {
+            cout << "  " << i + 1 << ". " << hits[i].file->GetName() << " in " << hits[i].folder->GetName()
+                 << " (Accessed: " << FormatTimestamp(hits[i].accessedAt / 1000000) << ")\n";
+        }
+        PrintLine();
+    }
+
+    // Needed for sharing
+    Folder* GetFolder(int id) { return myFolders.GetFolder(id); }
+    BPlusTreeFolders* GetFolderTree() { return &myFolders; }
+    TrashPolicy* GetTrashPolicy() { return &trash; }
+};
+
+/**
+ * @class UserDirectory
+ * @brief Owns every User and maps usernames to stable 32-bit user IDs.
+ *
+ * An ID is a slot in a vector and is never handed out twice, so the graph
+ * and sharing code can hold IDs instead of names. Deleting a user empties
+ * its slot without renumbering anyone else. Names are found through a hash
+ * index, so lookups do not grow with the number of users.
+ */
+class UserDirectory {
+public:
+    static const uint32_t NO_USER = UINT32_MAX;
+
+private:
+    vector<User*> slots;  // By ID; nullptr once deleted
+    unordered_map<string, uint32_t> byName;
+    uint32_t nextID = 0;  // Can run past slots after a load whose newest users were deleted
+
+public:
+    UserDirectory() {}
+    ~UserDirectory() { Clear(); }
+
+    UserDirectory(const UserDirectory&) = delete;
+    UserDirectory& operator=(const UserDirectory&) = delete;
+
+    // Takes ownership and assigns the next ID; NO_USER if the name is taken
+    uint32_t Add(User* u) {
+        if (nextID >= NO_USER || !byName.emplace(u->GetName(), nextID).second) return NO_USER;
+        u->id = nextID++;
+        slots.resize(nextID, nullptr);
+        slots[u->id] = u;
+        return u->id;
+    }
+
+    /**
+     * @brief  Snapshot load: puts a user back under the ID it had.
+     * @return false if the ID or name is already in use.
+     */
+    bool Restore(User* u, uint32_t id) {
+        if (id >= NO_USER) return false;
+        if (id >= slots.size()) slots.resize(id + 1, nullptr);
+        if (slots[id] || !byName.emplace(u->GetName(), id).second) return false;
+        u->id = id;
+        slots[id] = u;
+        nextID = max(nextID, id + 1);
+        return true;
+    }
+
+    // Makes sure IDs below bound are never handed out, even if their users are gone.
+    // Nothing is allocated for them, so a damaged bound cannot blow up a load.
+    void ReserveIDs(uint32_t bound) {
+        if (bound < NO_USER) nextID = max(nextID, bound);
+    }
+
+    uint32_t Find(const string& name) const {
+        auto it = byName.find(name);
+        return it == byName.end() ? NO_USER : it->second;
+    }
+
+    User* Get(uint32_t id) const { return id < slots.size() ? slots[id] : nullptr; }
+
+    User* FindUser(const string& name) const { return Get(Find(name)); }
+
+    // Deletes the user; its ID stays retired
+    bool Remove(uint32_t id) {
+        User* u = Get(id);
+        if (!u) return false;
+        byName.erase(u->GetName());
+        slots[id] = nullptr;
+        delete u;
+        return true;
+    }
+
+    // One past the highest ID in use; arrays indexed by ID need this many entries
+    uint32_t Bound() const { return slots.size(); }
+
+    // One past the highest ID ever handed out; saved so IDs stay retired across restarts
+    uint32_t NextID() const { return nextID; }
+
+    size_t Count() const { return byName.size(); }
+
+    // Visits every live user in ID order
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        for (User* u : slots) {
+            if (u) fn(*u);
+        }
+    }
+
+    void Clear() {
+        for (User* u : slots) delete u;
+        slots.clear();
+        byName.clear();
+        nextID = 0;
+    }
+};
+
+const uint64_t GRAPH_COMPACT_MIN = 4096;  // Pending edge changes before the friend graph is rebuilt
+
+/**
+ * @class FriendGraph
+ * @brief Undirected friendship graph over user IDs in compressed sparse row form.
+ *
+ * Each user's friends are a sorted slice of one shared target array, so the
+ * graph takes O(V + E) memory and a traversal reads every edge once. New
+ * friendships go into small sorted per-user delta rows; removed ones are
+ * shifted out of their slice and leave a dead slot at its end. Once the
+ * pending changes reach an eighth of the graph, Compact() merges everything
+ * back into a fresh CSR, so updates stay O(log d) amortised.
+ */
+class FriendGraph {
+    friend class DriveSnapshot;
+    friend class GraphAnalytics;
+private:
+    static constexpr uint32_t DEAD = UINT32_MAX;  // Freed slot at the end of a row; sorts last
+
+    vector<uint64_t> offsets;  // Row u is targets[offsets[u], offsets[u + 1])
+    vector<uint32_t> targets;
+    vector<uint32_t> degree;   // Live friends per user, base and delta together
+    unordered_map<uint32_t, vector<uint32_t>> delta;  // Sorted friends added since the last compaction
+    uint64_t pending = 0;      // Delta entries plus dead slots
+    uint64_t edgeCount = 0;
+
+    const vector<uint32_t>* DeltaRow(uint32_t u) const {
+        if (delta.empty()) return nullptr;  // Right after a compaction
+        auto it = delta.find(u);
+        return it == delta.end() ? nullptr : &it->second;
+    }
+
+    // Live part of u's CSR row: dead slots are always at its end
+    const uint32_t* BaseBegin(uint32_t u) const { return targets.data() + offsets[u]; }
+    const uint32_t* BaseEnd(uint32_t u) const {
+        const vector<uint32_t>* d = DeltaRow(u);
+        return BaseBegin(u) + (degree[u] - (d ? d->size() : 0));
+    }
+
+    bool HasHalf(uint32_t u, uint32_t v) const {
+        if (binary_search(BaseBegin(u), BaseEnd(u), v)) return true;
+        const vector<uint32_t>* d = DeltaRow(u);
+        return d && binary_search(d->begin(), d->end(), v);
+    }
+
+    void AddHalf(uint32_t u, uint32_t v) {
+        vector<uint32_t>& d = delta[u];
+        d.insert(lower_bound(d.begin(), d.end(), v), v);
+        degree[u]++;
+        pending++;
+    }
+
+    void RemoveHalf(uint32_t u, uint32_t v) {
+        auto it = delta.find(u);
+        if (it != delta.end()) {
+            vector<uint32_t>& d = it->second;
+            auto pos = lower_bound(d.begin(), d.end(), v);
+            if (pos != d.end() && *pos == v) {
+                d.erase(pos);
+                if (d.empty()) delta.erase(it);
+                degree[u]--;
+                pending--;
+                return;
+            }
+        }
+        uint32_t* begin = targets.data() + offsets[u];
+        uint32_t* end = begin + (BaseEnd(u) - BaseBegin(u));
+        uint32_t* pos = lower_bound(begin, end, v);
+        std::move(pos + 1, end, pos);
+        end[-1] = DEAD;
+        degree[u]--;
+        pending++;
+    }
+
+    void MaybeCompact() {
+        if (pending >= max<uint64_t>(GRAPH_COMPACT_MIN, (offsets.size() + targets.size()) / 8)) Compact();
+    }
+
+public:
+    FriendGraph() : offsets(1, 0) {}
+
+    uint32_t VertexCount() const { return degree.size(); }
+    uint64_t EdgeCount() const { return edgeCount; }
+    uint32_t Degree(uint32_t u) const { return u < degree.size() ? degree[u] : 0; }
+
+    // Makes room for IDs below n; new users start with no friends
+    void Resize(uint32_t n) {
+        if (n <= degree.size()) return;
+        offsets.resize(n + 1, offsets.back());
+        degree.resize(n, 0);
+    }
+
+    bool HasEdge(uint32_t u, uint32_t v) const {
+        if (u >= degree.size() || v >= degree.size()) return false;
+        return degree[u] <= degree[v] ? HasHalf(u, v) : HasHalf(v, u);
+    }
+
+    // False for self-loops, unknown IDs and existing friendships
+    bool AddEdge(uint32_t u, uint32_t v) {
+        if (u == v || u >= degree.size() || v >= degree.size() || HasEdge(u, v)) return false;
+        AddHalf(u, v);
+        AddHalf(v, u);
+        edgeCount++;
+        MaybeCompact();
+        return true;
+    }
+
+    bool RemoveEdge(uint32_t u, uint32_t v) {
+        if (!HasEdge(u, v)) return false;
+        RemoveHalf(u, v);
+        RemoveHalf(v, u);
+        edgeCount--;
+        MaybeCompact();
+        return true;
+    }
+
+    // Calls fn(v) for every friend of u in ascending ID order
+    template <typename Fn>
+    void ForEachNeighbor(uint32_t u, Fn fn) const {
+        if (u >= degree.size()) return;
+        const uint32_t* b = BaseBegin(u);
+        const uint32_t* be = BaseEnd(u);
+        const vector<uint32_t>* d = DeltaRow(u);
+        if (!d) {
+            for (; b != be; ++b) fn(*b);
+            return;
+        }
+        auto di = d->begin();
+        while (b != be || di != d->end()) {
+            if (di == d->end() || (b != be && *b < *di)) fn(*b++);
+            else fn(*di++);
+        }
+    }
+
+    vector<uint32_t> Neighbors(uint32_t u) const {
+        vector<uint32_t> out;
+        out.reserve(Degree(u));
+        ForEachNeighbor(u, [&out](uint32_t v) { out.push_back(v); });
+        return out;
+    }
+
+    // Merges the delta rows into a fresh CSR and drops dead slots
+    void Compact() {
+        uint32_t n = degree.size();
+        vector<uint64_t> newOffsets(n + 1, 0);
+        for (uint32_t u = 0; u < n; u++) newOffsets[u + 1] = newOffsets[u] + degree[u];
+        vector<uint32_t> newTargets(newOffsets[n]);
+        for (uint32_t u = 0; u < n; u++) {
+            const vector<uint32_t>* d = DeltaRow(u);
+            if (d) merge(BaseBegin(u), BaseEnd(u), d->begin(), d->end(), newTargets.begin() + newOffsets[u]);
+            else copy(BaseBegin(u), BaseEnd(u), newTargets.begin() + newOffsets[u]);
+        }
+        offsets.swap(newOffsets);
+        targets.swap(newTargets);
+        delta.clear();
+        pending = 0;
+    }
+
+    /**
+     * @brief  Replaces the graph with n users and the given undirected edges.
+     *         Duplicates are merged.
+     * @return false on a self-loop or an ID >= n (nothing is kept then).
+     */
+    bool Build(uint32_t n, const vector<pair<uint32_t, uint32_t>>& edges) {
+        Clear();
+        vector<uint64_t> fill(n + 1, 0);
+        for (const auto& e : edges) {
+            if (e.first == e.second || e.first >= n || e.second >= n) return false;
+            fill[e.first + 1]++;
+            fill[e.second + 1]++;
+        }
+        for (uint32_t u = 0; u < n; u++) fill[u + 1] += fill[u];
+        offsets = fill;
+        targets.resize(offsets[n]);
+        for (const auto& e : edges) {
+            targets[fill[e.first]++] = e.second;
+            targets[fill[e.second]++] = e.first;
+        }
+        degree.assign(n, 0);
+        for (uint32_t u = 0; u < n; u++) {
+            uint32_t* begin = targets.data() + offsets[u];
+            uint32_t* end = targets.data() + offsets[u + 1];
+            sort(begin, end);
+            uint32_t* last = unique(begin, end);
+            fill_n(last, end - last, DEAD);
+            degree[u] = last - begin;
+            pending += end - last;
+            edgeCount += last - begin;
+        }
+        edgeCount /= 2;
+        if (pending) Compact();
+        return true;
+    }
+
+    void Clear() {
+        offsets.assign(1, 0);
+        targets.clear();
+        degree.clear();
+        delta.clear();
+        pending = 0;
+        edgeCount = 0;
+    }
+
+    // Heap bytes held by the graph (delta rows estimated)
+    size_t MemoryBytes() const {
+        size_t bytes = offsets.capacity() * sizeof(uint64_t) + targets.capacity() * sizeof(uint32_t) +
+                       degree.capacity() * sizeof(uint32_t);
+        for (const auto& d : delta) bytes += d.second.capacity() * sizeof(uint32_t) + 32;
+        return bytes;
+    }
+};
+
+const int RECOMMEND_LIMIT = 10;           // Friend recommendations shown at once
+const uint64_t BOTTOM_UP_ALPHA = 4;       // Go bottom-up once the friends' edges pass 1/alpha of the graph
+
+/**
+ * @class FriendRecommender
+ * @brief Ranks friends-of-friends by how many friends they share with a user.
+ *
+ * Only the 2-hop neighbourhood is looked at. The user's friends are marked
+ * in a bitset frontier, then mutual counts come from one of two directions:
+ * top-down pushes from each friend to its friends (cost: the friends'
+ * degrees), bottom-up has every other user count its neighbours in the
+ * frontier (cost: one pass over the graph). The cheaper one is picked per
+ * call, as in direction-optimizing BFS, so hubs with thousands of friends
+ * do not fan out into millions of pushes. A bounded heap keeps the top k.
+ * The scratch arrays are kept between calls and only touched entries are
+ * reset, so a call never costs O(V) unless it goes bottom-up.
+ */
+class FriendRecommender {
+public:
+    struct Recommendation {
+        uint32_t id;
+        uint32_t mutual;  // Friends shared with the user
+    };
+
+private:
+    vector<uint64_t> frontier;  // Bit per user: friend of the user being served
+    vector<uint32_t> mutual;    // Top-down counts, zero outside touched
+    vector<uint32_t> touched;
+
+    bool InFrontier(uint32_t v) const { return frontier[v >> 6] >> (v & 63) & 1; }
+
+    // More mutual friends first, then lower ID
+    static bool Better(const Recommendation& a, const Recommendation& b) {
+        return a.mutual != b.mutual ? a.mutual > b.mutual : a.id < b.id;
+    }
+
+    // Heap with the weakest kept candidate on top
+    static void Offer(vector<Recommendation>& heap, size_t k, Recommendation r) {
+        if (heap.size() < k) {
+            heap.push_back(r);
+            push_heap(heap.begin(), heap.end(), Better);
+        } else if (Better(r, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), Better);
+            heap.back() = r;
+            push_heap(heap.begin(), heap.end(), Better);
+        }
+    }
+
+public:
+    bool lastBottomUp = false;  // Direction the last call took
+
+    /**
+     * @brief  Top k users who are not yet friends with u, by mutual friends.
+     * @return Best first; empty if u has no friends of friends.
+     */
+    vector<Recommendation> Recommend(const FriendGraph& g, uint32_t u, size_t k) {
+        vector<Recommendation> heap;
+        uint32_t n = g.VertexCount();
+        if (u >= n || k == 0) return heap;
+        if (frontier.size() < (n + 63) / 64) frontier.resize((n + 63) / 64, 0);
+        if (mutual.size() < n) mutual.resize(n, 0);
+
+        uint64_t pushWork = 0;
+        g.ForEachNeighbor(u, [&](uint32_t f) {
+            frontier[f >> 6] |= 1ULL << (f & 63);
+            pushWork += g.Degree(f);
+        });
+
+        lastBottomUp = pushWork * BOTTOM_UP_ALPHA > 2 * g.EdgeCount() + n;
+        if (lastBottomUp) {
+            for (uint32_t w = 0; w < n; w++) {
+                if (w == u || InFrontier(w) || g.Degree(w) == 0) continue;
+                uint32_t count = 0;
+                g.ForEachNeighbor(w, [&](uint32_t v) { count += InFrontier(v); });
+                if (count) Offer(heap, k, {w, count});
+            }
+        } else {
+            g.ForEachNeighbor(u, [&](uint32_t f) {
+                g.ForEachNeighbor(f, [&](uint32_t w) {
+                    if (w == u || InFrontier(w)) return;
+                    if (mutual[w]++ == 0) touched.push_back(w);
+                });
+            });
+            for (uint32_t w : touched) {
+                Offer(heap, k, {w, mutual[w]});
+                mutual[w] = 0;
+            }
+            touched.clear();
+        }
+
+        g.ForEachNeighbor(u, [&](uint32_t f) { frontier[f >> 6] &= ~(1ULL << (f & 63)); });
+        sort_heap(heap.begin(), heap.end(), Better);
+        return heap;
+    }
+};
+
+/**
+ * @class FriendComponents
+ * @brief Connected components of the friend graph as a union-find forest.
+ *
+ * New friendships are unioned in as they are made (union by size, path
+ * halving), so "are we connected" and "how big is my network" are near
+ * O(1). Each component also threads its members on a circular list, which
+ * two unions splice together in O(1), so listing a network costs only its
+ * size. Union-find cannot split a set, so removing friendships just marks
+ * the forest stale and the next query rebuilds it from the graph.
+ */
+class FriendComponents {
+private:
+    vector<uint32_t> parent;  // Roots point to themselves
+    vector<uint32_t> size;    // Members per component, valid at roots
+    vector<uint32_t> ring;    // Next member of the same component
+    bool stale = false;
+
+public:
+    // New IDs start as components of their own
+    void Resize(uint32_t n) {
+        for (uint32_t v = parent.size(); v < n; v++) {
+            parent.push_back(v);
+            size.push_back(1);
+            ring.push_back(v);
+        }
+    }
+
+    uint32_t Find(uint32_t v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    }
+
+    // Returns false if a and b were already connected
+    bool Union(uint32_t a, uint32_t b) {
+        a = Find(a);
+        b = Find(b);
+        if (a == b) return false;
+        if (size[a] < size[b]) swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        swap(ring[a], ring[b]);  // Splices the two member lists
+        return true;
+    }
+
+    bool Connected(uint32_t a, uint32_t b) { return Find(a) == Find(b); }
+
+    uint32_t ComponentSize(uint32_t v) { return size[Find(v)]; }
+
+    // Calls fn for every member of v's component, v first
+    template <typename Fn>
+    void ForEachMember(uint32_t v, Fn fn) const {
+        uint32_t u = v;
+        do {
+            fn(u);
+            u = ring[u];
+        } while (u != v);
+    }
+
+    // Call after removing a friendship
+    void Invalidate() { stale = true; }
+    bool Stale() const { return stale; }
+
+    void Rebuild(const FriendGraph& g) {
+        parent.clear();
+        size.clear();
+        ring.clear();
+        Resize(g.VertexCount());
+        for (uint32_t u = 0; u < g.VertexCount(); u++) {
+            g.ForEachNeighbor(u, [&](uint32_t v) {
+                if (v > u) Union(u, v);
+            });
+        }
+        stale = false;
+    }
+};
+
+const uint32_t PATH_MAX_HOPS = 6;  // Default hop limit for path queries ("six degrees")
+const int PATH_QUERY_LIMIT = 10;   // Most paths one query lists
+
+/**
+ * @class PathFinder
+ * @brief Shortest and k-shortest friendship paths between two users.
+ *
+ * Shortest() runs a bidirectional BFS: one level at a time from whichever
+ * end has the smaller frontier, until the two searches meet. Each side only
+ * has to reach about half the distance, so on a social graph it touches a
+ * tiny fraction of the users a one-sided BFS would. KShortest() is Yen's
+ * algorithm on top of it: each further path branches off an earlier one at
+ * a spur user, with the earlier paths' next hops from that user blocked.
+ * Both respect a hop limit. Scratch arrays are kept between queries and
+ * only touched entries are reset.
+ */
+class PathFinder {
+public:
+    typedef vector<uint32_t> Path;  // User IDs from source to target
+
+private:
+    static constexpr uint32_t UNSEEN = UINT32_MAX;
+
+    struct Side {
+        vector<uint32_t> dist, parent;
+        vector<uint32_t> frontier, next, touched;
+        uint32_t depth = 0;
+    };
+
+    Side fwd, bwd;
+    vector<bool> blocked;          // Users a spur search may not pass through
+    uint32_t spur = UNSEEN;        // Spur user whose edges to spurBlocked are unusable
+    vector<uint32_t> spurBlocked;
+
+    void Visit(Side& s, uint32_t v, uint32_t d, uint32_t parent) {
+        s.dist[v] = d;
+        s.parent[v] = parent;
+        s.touched.push_back(v);
+        s.next.push_back(v);
+    }
+
+    void Reset(Side& s) {
+        for (uint32_t v : s.touched) s.dist[v] = UNSEEN;
+        s.touched.clear();
+        s.frontier.clear();
+        s.next.clear();
+        s.depth = 0;
+    }
+
+    bool EdgeBlocked(uint32_t u, uint32_t v) const {
+        if (u == spur) return find(spurBlocked.begin(), spurBlocked.end(), v) != spurBlocked.end();
+        if (v == spur) return find(spurBlocked.begin(), spurBlocked.end(), u) != spurBlocked.end();
+        return false;
+    }
+
+    /**
+     * @brief Expands side a by one level. Every edge into a user side b has
+     *        seen is a meeting; the shortest one is kept in best/meetA/meetB.
+     */
+    void Expand(const FriendGraph& g, Side& a, Side& b, uint32_t& best, uint32_t& meetA, uint32_t& meetB) {
+        a.frontier.swap(a.next);
+        a.next.clear();
+        for (uint32_t u : a.frontier) {
+            g.ForEachNeighbor(u, [&](uint32_t v) {
+                if (blocked[v] || EdgeBlocked(u, v)) return;
+                if (b.dist[v] != UNSEEN && a.depth + 1 + b.dist[v] < best) {
+                    best = a.depth + 1 + b.dist[v];
+                    meetA = u;
+                    meetB = v;
+                }
+                if (a.dist[v] == UNSEEN) Visit(a, v, a.depth + 1, u);
+            });
+        }
+        a.depth++;
+    }
+
+    // Walks parents from v back to the side's root, nearest the root first
+    static Path Trace(const Side& s, uint32_t v) {
+        Path p;
+        for (; v != UNSEEN; v = s.parent[v]) p.push_back(v);
+        reverse(p.begin(), p.end());
+        return p;
+    }
+
+public:
+    /**
+     * @brief  A shortest path from s to t with at most maxHops friendships.
+     * @return Empty if there is none (or either user is out of range).
+     */
+    Path Shortest(const FriendGraph& g, uint32_t s, uint32_t t, uint32_t maxHops = PATH_MAX_HOPS) {
+        uint32_t n = g.VertexCount();
+        if (s >= n || t >= n) return Path();
+        if (s == t) return Path(1, s);
+        if (fwd.dist.size() < n) {
+            for (Side* side : {&fwd, &bwd}) {
+                side->dist.resize(n, UNSEEN);
+                side->parent.resize(n, UNSEEN);
+            }
+        }
+        if (blocked.size() < n) blocked.resize(n, false);
+        if (blocked[s] || blocked[t]) return Path();
+
+        Visit(fwd, s, 0, UNSEEN);
+        Visit(bwd, t, 0, UNSEEN);
+        uint32_t best = UNSEEN, meetF = UNSEEN, meetB = UNSEEN;
+        while (best == UNSEEN && !fwd.next.empty() && !bwd.next.empty() && fwd.depth + bwd.depth < maxHops) {
+            if (fwd.next.size() <= bwd.next.size()) Expand(g, fwd, bwd, best, meetF, meetB);
+            else Expand(g, bwd, fwd, best, meetB, meetF);
+        }
+
+        Path path;
+        if (best != UNSEEN) {
+            path = Trace(fwd, meetF);
+            Path back = Trace(bwd, meetB);
+            path.insert(path.end(), back.rbegin(), back.rend());
+        }
+        Reset(fwd);
+        Reset(bwd);
+        return path;
+    }
+
+    /**
+     * @brief  Up to k loop-free paths from s to t, shortest first, each with
+     *         at most maxHops friendships (Yen's algorithm).
+     */
+    vector<Path> KShortest(const FriendGraph& g, uint32_t s, uint32_t t, size_t k, uint32_t maxHops = PATH_MAX_HOPS) {
+        vector<Path> found;
+        if (k == 0) return found;
+        Path first = Shortest(g, s, t, maxHops);
+        if (first.empty()) return found;
+        found.push_back(first);
+
+        set<pair<size_t, Path>> candidates;  // Ordered by length, then by IDs
+        while (found.size() < k && found.back().size() > 1) {
+            const Path prev = found.back();
+            for (size_t i = 0; i + 1 < prev.size(); i++) {
+                spur = prev[i];
+                spurBlocked.clear();
+                for (const Path& p : found) {
+                    if (p.size() > i + 1 && equal(prev.begin(), prev.begin() + i + 1, p.begin())) {
+                        spurBlocked.push_back(p[i + 1]);
+                    }
+                }
+                for (size_t j = 0; j < i; j++) blocked[prev[j]] = true;
+
+                Path tail = Shortest(g, spur, t, maxHops - i);
+
+                for (size_t j = 0; j < i; j++) blocked[prev[j]] = false;
+                if (!tail.empty()) {
+                    Path total(prev.begin(), prev.begin() + i);
+                    total.insert(total.end(), tail.begin(), tail.end());
+                    candidates.insert({total.size(), total});
+                }
+            }
+            spur = UNSEEN;
+            spurBlocked.clear();
+            if (candidates.empty()) break;
+            found.push_back(candidates.begin()->second);
+            candidates.erase(candidates.begin());
+        }
+        return found;
+    }
+};
+
+const uint32_t ANALYTICS_CHUNK = 1024;  // Users handed to a thread at a time
+const int ANALYTICS_HUBS = 5;           // Best-connected users listed in a report
+const int AFFOREST_ROUNDS = 2;          // Neighbours linked per user before sampling the giant component
+const int AFFOREST_SAMPLES = 1024;
+
+/**
+ * @class GraphAnalytics
+ * @brief Whole-network statistics computed on every core as one batch job.
+ *
+ * A job compacts the friend graph and then runs three passes over the CSR
+ * arrays: degree statistics, connected components and a level-synchronous
+ * BFS from one user. Users are handed to threads in chunks from a shared
+ * counter, so a few hubs cannot leave the other threads idle.
+ *
+ * Components use Afforest: every user is first linked to only its first
+ * two friends with a lock-free union-find, which already joins most of
+ * the giant component. A sample then finds that component, and only users
+ * outside it link their remaining friends. Each undirected edge is seen
+ * from both ends, so skipping the giant component's side loses nothing.
+ * The BFS claims users with a compare-and-swap on their distance and
+ * collects the next frontier in per-thread buffers.
+ */
+class GraphAnalytics {
+public:
+    static constexpr uint32_t UNREACHED = UINT32_MAX;
+
+    struct Report {
+        time_t computedAt = 0;
+        size_t threads = 0;
+        uint64_t friendships = 0;
+        uint32_t users = 0, isolated = 0, maxDegree = 0;
+        double meanDegree = 0;
+        vector<uint64_t> degreeBuckets;                  // [0]: no friends, [b]: 2^(b-1) .. 2^b - 1 friends
+        vector<pair<uint32_t, uint32_t>> hubs;           // (user ID, friends), most friends first
+        uint32_t components = 0, largestComponent = 0;   // Users without friends count as their own component
+        uint32_t source = UNREACHED;                     // BFS start
+        uint64_t reached = 0;
+        vector<uint64_t> levelSizes;                     // Users at each distance from source
+        double meanDistance = 0;
+        double degreeMillis = 0, componentMillis = 0, bfsMillis = 0;
+    };
+
+private:
+    // Calls fn(thread, begin, end) over chunks of [0, n) taken from a shared counter
+    template <typename Fn>
+    static void ForChunks(size_t threads, uint32_t n, Fn fn) {
+        atomic<uint64_t> next(0);
+        ParallelSort::Run(threads, [&](size_t t) {
+            for (uint64_t b; (b = next.fetch_add(ANALYTICS_CHUNK)) < n;) {
+                fn(t, (uint32_t)b, (uint32_t)min<uint64_t>(n, b + ANALYTICS_CHUNK));
+            }
+        });
+    }
+
+    static double MillisSince(chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Lock-free union: the higher root is pointed at the lower one
+    static void Link(uint32_t u, uint32_t v, vector<atomic<uint32_t>>& comp) {
+        uint32_t p1 = comp[u].load(memory_order_relaxed);
+        uint32_t p2 = comp[v].load(memory_order_relaxed);
+        while (p1 != p2) {
+            uint32_t high = max(p1, p2), low = min(p1, p2);
+            uint32_t pHigh = comp[high].load(memory_order_relaxed);
+            if (pHigh == low) break;
+            if (pHigh == high && comp[high].compare_exchange_strong(pHigh, low)) break;
+            p1 = comp[comp[high].load(memory_order_relaxed)].load(memory_order_relaxed);
+            p2 = comp[low].load(memory_order_relaxed);
+        }
+    }
+
+    static void Compress(size_t threads, vector<atomic<uint32_t>>& comp) {
+        ForChunks(threads, comp.size(), [&](size_t, uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++) {
+                uint32_t c = comp[v].load(memory_order_relaxed);
+                while (c != comp[c].load(memory_order_relaxed)) c = comp[c].load(memory_order_relaxed);
+                comp[v].store(c, memory_order_relaxed);
+            }
+        });
+    }
+
+    static const uint32_t* Row(const FriendGraph& g, uint32_t u) { return g.targets.data() + g.offsets[u]; }
+
+public:
+    // Component label (smallest ID in it) for every user; g must be compacted
+    static vector<uint32_t> Components(const FriendGraph& g, size_t threads) {
+        uint32_t n = g.VertexCount();
+        vector<atomic<uint32_t>> comp(n);
+        ForChunks(threads, n, [&](size_t, uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++) comp[v].store(v, memory_order_relaxed);
+        });
+
+        for (int r = 0; r < AFFOREST_ROUNDS; r++) {
+            ForChunks(threads, n, [&](size_t, uint32_t begin, uint32_t end) {
+                for (uint32_t v = begin; v < end; v++) {
+                    if (g.degree[v] > (uint32_t)r) Link(v, Row(g, v)[r], comp);
+                }
+            });
+            Compress(threads, comp);
+        }
+
+        uint32_t giant = UNREACHED;
+        if (n > 0) {
+            mt19937 rng(n);
+            unordered_map<uint32_t, int> seen;
+            int best = 0;
+            for (int i = 0; i < AFFOREST_SAMPLES; i++) {
+                uint32_t label = comp[rng() % n].load(memory_order_relaxed);
+                int c = ++seen[label];
+                if (c > best || (c == best && label < giant)) {
+                    best = c;
+                    giant = label;
+                }
+            }
+        }
+
+        ForChunks(threads, n, [&](size_t, uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++) {
+                if (comp[v].load(memory_order_relaxed) == giant) continue;
+                const uint32_t* row = Row(g, v);
+                for (uint32_t i = AFFOREST_ROUNDS; i < g.degree[v]; i++) Link(v, row[i], comp);
+            }
+        });
+        Compress(threads, comp);
+
+        vector<uint32_t> labels(n);
+        for (uint32_t v = 0; v < n; v++) labels[v] = comp[v].load(memory_order_relaxed);
+        return labels;
+    }
+
+    // Hop distance from source to every user (UNREACHED if none); g must be compacted
+    static vector<uint32_t> Distances(const FriendGraph& g, uint32_t source, size_t threads,
+                                      vector<uint64_t>* levelSizes = nullptr) {
+        uint32_t n = g.VertexCount();
+        vector<atomic<uint32_t>> dist(n);
+        ForChunks(threads, n, [&](size_t, uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++) dist[v].store(UNREACHED, memory_order_relaxed);
+        });
+
+        vector<uint32_t> frontier;
+        if (source < n) {
+            dist[source].store(0, memory_order_relaxed);
+            frontier.push_back(source);
+        }
+        vector<vector<uint32_t>> next(threads);
+        for (uint32_t depth = 1; !frontier.empty(); depth++) {
+            if (levelSizes) levelSizes->push_back(frontier.size());
+            size_t levelThreads = min<size_t>(threads, (frontier.size() + ANALYTICS_CHUNK - 1) / ANALYTICS_CHUNK);
+            ForChunks(levelThreads, frontier.size(), [&](size_t t, uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++) {
+                    uint32_t u = frontier[i];
+                    const uint32_t* row = Row(g, u);
+                    for (uint32_t j = 0; j < g.degree[u]; j++) {
+                        uint32_t v = row[j], expected = UNREACHED;
+                        if (dist[v].load(memory_order_relaxed) == UNREACHED &&
+                            dist[v].compare_exchange_strong(expected, depth, memory_order_relaxed)) {
+                            next[t].push_back(v);
+                        }
+                    }
+                }
+            });
+            frontier.clear();
+            for (vector<uint32_t>& part : next) {
+                frontier.insert(frontier.end(), part.begin(), part.end());
+                part.clear();
+            }
+        }
+
+        vector<uint32_t> out(n);
+        for (uint32_t v = 0; v < n; v++) out[v] = dist[v].load(memory_order_relaxed);
+        return out;
+    }
 
-        cout << " [SUCCESS] File '" << fname << "' created (ID: " << fileIDCounter << ").\n";
-        sysLog.Log("FileCreated", "File " + fname + " created in " + name);
-        fileIDCounter++;
+    /**
+     * @brief  Runs the whole job. Only users marked in live are counted
+     *         (deleted IDs stay in the graph as isolated vertices).
+     */
+    static Report Analyze(FriendGraph& g, const vector<bool>& live, uint32_t source) {
+        if (g.pending) g.Compact();  // The passes read the CSR arrays directly
+        uint32_t n = g.VertexCount();
+        Report rep;
+        rep.computedAt = time(nullptr);
+        rep.threads = ParallelSort::Threads(n + 2 * g.EdgeCount());
+        rep.friendships = g.EdgeCount();
+        rep.source = source;
+
+        // Degrees: each thread keeps its own totals, histogram and hubs
+        auto start = chrono::steady_clock::now();
+        struct Partial {
+            uint64_t users = 0, isolated = 0, sum = 0;
+            uint32_t maxDegree = 0;
+            vector<uint64_t> buckets = vector<uint64_t>(33, 0);
+            vector<pair<uint32_t, uint32_t>> hubs;
+        };
+        auto heavier = [](const pair<uint32_t, uint32_t>& a, const pair<uint32_t, uint32_t>& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        };
+        vector<Partial> parts(rep.threads);
+        ForChunks(rep.threads, n, [&](size_t t, uint32_t begin, uint32_t end) {
+            Partial& p = parts[t];
+            for (uint32_t v = begin; v < end; v++) {
+                if (!live[v]) continue;
+                uint32_t d = g.degree[v];
+                p.users++;
+                p.sum += d;
+                p.maxDegree = max(p.maxDegree, d);
+                if (d == 0) p.isolated++;
+                int b = 0;
+                while (d >> b) b++;
+                p.buckets[b]++;
+                if (p.hubs.size() < (size_t)ANALYTICS_HUBS || heavier({v, d}, p.hubs.front())) {
+                    if (p.hubs.size() == (size_t)ANALYTICS_HUBS) {
+                        pop_heap(p.hubs.begin(), p.hubs.end(), heavier);
+                        p.hubs.pop_back();
+                    }
+                    p.hubs.push_back({v, d});
+                    push_heap(p.hubs.begin(), p.hubs.end(), heavier);
+                }
+            }
+        });
+        rep.degreeBuckets.assign(33, 0);
+        uint64_t sum = 0;
+        for (const Partial& p : parts) {
+            rep.users += p.users;
+            rep.isolated += p.isolated;
+            sum += p.sum;
+            rep.maxDegree = max(rep.maxDegree, p.maxDegree);
+            for (size_t b = 0; b < p.buckets.size(); b++) rep.degreeBuckets[b] += p.buckets[b];
+            rep.hubs.insert(rep.hubs.end(), p.hubs.begin(), p.hubs.end());
+        }
+        while (rep.degreeBuckets.size() > 1 && rep.degreeBuckets.back() == 0) rep.degreeBuckets.pop_back();
+        sort(rep.hubs.begin(), rep.hubs.end(), heavier);
+        if (rep.hubs.size() > (size_t)ANALYTICS_HUBS) rep.hubs.resize(ANALYTICS_HUBS);
+        rep.meanDegree = rep.users ? (double)sum / rep.users : 0;
+        rep.degreeMillis = MillisSince(start);
+
+        start = chrono::steady_clock::now();
+        vector<uint32_t> labels = Components(g, rep.threads);
+        vector<uint32_t> sizes(n, 0);
+        for (uint32_t v = 0; v < n; v++) {
+            if (live[v]) sizes[labels[v]]++;
+        }
+        for (uint32_t s : sizes) {
+            if (s == 0) continue;
+            rep.components++;
+            rep.largestComponent = max(rep.largestComponent, s);
+        }
+        rep.componentMillis = MillisSince(start);
+
+        start = chrono::steady_clock::now();
+        if (source < n) {
+            vector<uint32_t> dist = Distances(g, source, rep.threads, &rep.levelSizes);
+            uint64_t total = 0;
+            for (size_t d = 0; d < rep.levelSizes.size(); d++) {
+                rep.reached += rep.levelSizes[d];
+                total += d * rep.levelSizes[d];
+            }
+            rep.meanDistance = rep.reached > 1 ? (double)total / (rep.reached - 1) : 0;
+        }
+        rep.bfsMillis = MillisSince(start);
+        return rep;
     }
+};
 
-    void InsertSharedFile(File f) {
-        f.SetID(fileIDCounter++);
-        files.Insert(f);
-        if(f.GetPriority() >= 8) starredFiles.Insert(f);
+class UserGraph {
+    friend class DriveSnapshot;
+private:
+    UserDirectory users;
+    FriendGraph adj; // Friendships, indexed by user ID
+    TrieUsers userTrie; // For fast search
+    FriendRecommender recommender;
+    PathFinder pathFinder;
+    FriendComponents components;
+    GraphAnalytics::Report lastReport;  // Most recent analytics job
+
+    int FriendCount(uint32_t id) const { return adj.Degree(id); }
+
+    // Rebuilt on first use after friendships were removed
+    FriendComponents& Components() {
+        if (components.Stale()) components.Rebuild(adj);
+        return components;
     }
 
-    void SearchFile() {
-        int searchId = InputInt(" Enter File ID to search: ");
-        File* f = files.Search(searchId);
-        if (f) {
-            f->DisplayDetailed();
-            recentFiles.Enqueue(*f);
-            sysLog.Log("FileAccessed", "Viewed file ID " + to_string(searchId));
-        } else {
-            cout << " [ERROR] File not found.\n";
+    // The receiver's "Shared with Me" folder, created on first use
+    Folder* SharedFolderOf(User* receiver) {
+        // Use a special high ID (9999) for shared folder to avoid conflicts
+        Folder* sharedFolder = receiver->GetFolder(9999);
+        if (!sharedFolder) {
+            Folder newShared;
+            newShared.SetValues("Shared with Me", 9999, receiver->GetName());
+            newShared.SetTrashPolicy(receiver->GetTrashPolicy());
+            sharedFolder = receiver->GetFolderTree()->AddFolder(move(newShared));
         }
+        return sharedFolder;
     }
 
-    void DeleteFile() {
-        int delId = InputInt(" Enter File ID to delete: ");
-        File f = files.Delete(delId);
-        if (f.GetID() > 0) {
-            deletedFiles.Push(f);
-            cout << " [SUCCESS] File moved to Trash.\n";
-            sysLog.Log("FileDeleted", "Deleted file ID " + to_string(delId));
-        } else {
-            cout << " [ERROR] File not found.\n";
+public:
+    UserGraph() {}
+
+    /**
+     * @brief  Registers a user without any prompts.
+     * @return false if the username is already taken.
+     */
+    bool RegisterUser(const string &u, const string &p, const string &sq, const string &sa) {
+        if (users.Find(u) != UserDirectory::NO_USER) return false;
+
+        User* newUser = new User();
+        newUser->Setup(u, p, sq, sa);
+        if (users.Add(newUser) == UserDirectory::NO_USER) {
+            delete newUser;
+            return false;
         }
+        adj.Resize(users.Bound());
+        components.Resize(users.Bound());
+
+        userTrie.Insert(u);
+        sysLog.Log("UserRegister", "New user registered: " + u);
+        journal.Append(JournalRecord(JOP_REGISTER).Str(u).Str(p).Str(sq).Str(sa));
+        return true;
     }
 
-    void RecoverFile() {
-        if(deletedFiles.IsEmpty()) {
-            cout << " [INFO] Trash is empty.\n";
+    void RegisterUser() {
+        PrintHeader("NEW USER REGISTRATION");
+        string u = InputString(" Choose Username: ");
+        if (users.Find(u) != UserDirectory::NO_USER) {
+            cout << " [ERROR] Username taken.\n";
             return;
         }
-        File f = deletedFiles.Pop();
-        files.Insert(f);
-        cout << " [SUCCESS] Restored '" << f.GetName() << "'.\n";
-        sysLog.Log("FileRestored", "Restored file " + f.GetName());
+
+        string p = InputString(" Choose Password: ");
+        string sq = InputString(" Security Question: ");
+        string sa = InputString(" Security Answer: ");
+
+        if (RegisterUser(u, p, sq, sa)) cout << " [SUCCESS] User registered!\n";
     }
 
-    void BrowseFiles() {
-        vector<File> fileList = files.GetFilesVector();
-        if (fileList.empty()) {
-            cout << " [INFO] No files to browse.\n";
-            return;
+    // Returns the user on a correct username/password pair, nullptr otherwise
+    User* Login(const string &u, const string &p) {
+        User* user = users.FindUser(u);
+        if (!user || !user->CheckPassword(p)) return nullptr;
+        sysLog.Log("Login", "User " + u + " logged in.");
+        return user;
+    }
+
+    User* Login() {
+        PrintHeader("LOGIN");
+        string u = InputString(" Username: ");
+        if (!users.FindUser(u)) {
+            cout << " [ERROR] User not found.\n";
+            return nullptr;
         }
         
-        fileNavigator.BuildFromVector(fileList);
-        fileNavigator.Reset();
+        string p = InputString(" Password: ");
+        User* user = Login(u, p);
+        if(!user) cout << " [ERROR] Incorrect password.\n";
+        return user;
+    }
+    
+    User* FindUser(const string &name) { return users.FindUser(name); }
+
+    User* GetUser(uint32_t id) { return users.Get(id); }
+
+    /**
+     * @brief  Deletes an account with its folders, friendships and name.
+     *         Other users keep their IDs; files already shared were copies
+     *         and stay with their receivers.
+     * @return false if the user does not exist.
+     */
+    bool DeleteUser(const string &u) {
+        uint32_t id = users.Find(u);
+        if (id == UserDirectory::NO_USER) return false;
+        for (uint32_t v : adj.Neighbors(id)) {
+            adj.RemoveEdge(id, v);
+            userTrie.SetScore(users.Get(v)->GetName(), FriendCount(v));
+            components.Invalidate();
+        }
+        userTrie.Remove(u);
+        users.Remove(id);
+        sysLog.Log("UserDelete", "Account deleted: " + u);
+        journal.Append(JournalRecord(JOP_DELETE_USER).Str(u));
+        return true;
+    }
+
+    // Asks for the password again; returns true if the account is gone
+    bool DeleteUser(User* currentUser) {
+        PrintHeader("DELETE ACCOUNT");
+        string p = InputString(" Confirm your password: ");
+        if (!currentUser->CheckPassword(p)) {
+            cout << " [ERROR] Incorrect password.\n";
+            return false;
+        }
+        string confirm = InputString(" This removes all your folders and files. Continue? (y/n): ");
+        if (confirm != "y" && confirm != "Y") {
+            cout << " [INFO] Account kept.\n";
+            return false;
+        }
+        DeleteUser(currentUser->GetName());
+        cout << " [SUCCESS] Account deleted.\n";
+        return true;
+    }
+
+    bool ResetPassword(const string &u, const string &newP) {
+        User* user = FindUser(u);
+        if (!user) return false;
+        user->SetPassword(newP);
+        sysLog.Log("PassReset", "Password reset for " + u);
+        journal.Append(JournalRecord(JOP_RESET_PASSWORD).Str(u).Str(newP));
+        return true;
+    }
+
+    void RecoverAccount() {
+        string u = InputString(" Enter Username to recover: ");
+        User* user = users.FindUser(u);
+        if (!user) { cout << " User not found.\n"; return; }
         
-        while (true) {
-            ClearScreen();
-            PrintHeader("BROWSE FILES (Double Linked List)");
-            File* current = fileNavigator.GetCurrent();
-            if (current) {
-                current->DisplayDetailed();
-                cout << "\n Navigation:\n";
-                cout << " [N] Next File  [P] Previous File  [Q] Quit\n";
-                cout << " [V] View Version History\n";
-                PrintLine();
-                
-                char choice;
-                cout << " Enter choice: ";
-                cin >> choice;
-                cin.ignore();
-                choice = tolower(choice);
-                
-                switch(choice) {
-                    case 'n':
-                        if (fileNavigator.GetNext()) {
-                            cout << " Moved to next file.\n";
-                        } else {
-                            cout << " [INFO] Already at last file.\n";
-                        }
-                        break;
-                    case 'p':
-                        if (fileNavigator.GetPrev()) {
-                            cout << " Moved to previous file.\n";
-                        } else {
-                            cout << " [INFO] Already at first file.\n";
-                        }
-                        break;
-                    case 'v': {
-                        File* f = fileNavigator.GetCurrent();
-                        if (f) {
-                            PrintHeader("VERSION HISTORY (Linked List)");
-                            f->DisplayVersionHistory();
-                        }
-                        break;
-                    }
-                    case 'q':
-                        return;
-                    default:
-                        cout << " Invalid choice.\n";
-                }
-                cout << "\n (Press Enter to continue...)";
-                cin.get();
-            } else {
-                cout << " [ERROR] No files available.\n";
-                return;
-            }
+        cout << " Security Question: " << user->GetSecQ() << endl;
+        string ans = InputString(" Answer: ");
+        if(user->CheckSecA(ans)) {
+            string newP = InputString(" Enter New Password: ");
+            ResetPassword(u, newP);
+            cout << " [SUCCESS] Password reset.\n";
+        } else {
+            cout << " [ERROR] Wrong answer.\n";
         }
     }
 
-    void ViewFileVersions() {
-        int fileId = InputInt(" Enter File ID to view versions: ");
-        File* f = files.Search(fileId);
-        if (f) {
-            PrintHeader("VERSION HISTORY (Linked List)");
-            f->DisplayVersionHistory();
-            cout << "\n Total versions: " << f->GetVersionCount() << endl;
+    // --- FRIENDSHIP & GRAPH ALGORITHMS ---
+
+    enum FriendResult { FRIEND_ADDED, FRIEND_INVALID, FRIEND_EXISTS };
+
+    FriendResult AddFriend(User* currentUser, const string &target) {
+        uint32_t u1 = currentUser->GetID();
+        uint32_t u2 = users.Find(target);
+
+        if (u2 == UserDirectory::NO_USER || u1 == u2) return FRIEND_INVALID;
+        if(!adj.AddEdge(u1, u2)) return FRIEND_EXISTS;
+        components.Union(u1, u2);
+
+        userTrie.SetScore(currentUser->GetName(), FriendCount(u1));  // Autocomplete ranks by friend count
+        userTrie.SetScore(target, FriendCount(u2));
+        sysLog.Log("Friend", currentUser->GetName() + " befriended " + target);
+        journal.Append(JournalRecord(JOP_ADD_FRIEND).Str(currentUser->GetName()).Str(target));
+        return FRIEND_ADDED;
+    }
+
+    // Best-connected usernames starting with prefix
+    vector<TrieUsers::Suggestion> Suggest(const string& prefix, size_t k = AUTOCOMPLETE_LIMIT) const {
+        return userTrie.AutoComplete(prefix, k);
+    }
+
+    void AddFriend(User* currentUser) {
+        cout << " Find Friend (Autocomplete):\n";
+        string prefix = Trim(InputString(" Enter prefix to search: "));
+        vector<TrieUsers::Suggestion> hits = Suggest(prefix);
+        if (hits.empty()) {
+            cout << " No users found with prefix '" << prefix << "'.\n";
         } else {
-            cout << " [ERROR] File not found.\n";
+            cout << " Suggestions for '" << prefix << "' (most connected first):\n";
+            for (const TrieUsers::Suggestion& s : hits) cout << " - " << s.name << " (" << s.score << " friends)\n";
+        }
+
+        string target = Trim(InputString(" Enter exact username to add: "));
+
+        switch(AddFriend(currentUser, target)) {
+            case FRIEND_INVALID:
+                cout << " [ERROR] Invalid user.\n";
+                break;
+            case FRIEND_EXISTS:
+                cout << " [INFO] Already friends.\n";
+                break;
+            case FRIEND_ADDED:
+                cout << " [SUCCESS] You are now friends with " << target << "!\n";
+                break;
         }
     }
 
-    void ShowMenu() {
-        while(true) {
-            PrintHeader("FOLDER: " + name);
-            cout << " 1. Create File\n";
-            cout << " 2. List All Files\n";
-            cout << " 3. Search File\n";
-            cout << " 4. Delete File\n";
-            cout << " 5. Trash Bin (Undo)\n";
-            cout << " 6. Recover Last Deleted\n";
-            cout << " 7. Recent Files\n";
-            cout << " 8. Starred/Priority Files\n";
-            cout << " 9. Browse Files (Double Linked List)\n";
-            cout << " 10. View File Version History (Linked List)\n";
-            cout << " --- SORTING ALGORITHMS ---\n";
-            cout << " 11. Sort: By Size (Bubble Sort)\n";
-            cout << " 12. Sort: By Size (Insertion Sort)\n";
-            cout << " 13. Sort: By Size (Selection Sort)\n";
-            cout << " 14. Sort: By Size (Merge Sort)\n";
-            cout << " 15. Sort: By Size (Heap Sort)\n";
-            cout << " 16. Sort: By Size (Counting Sort)\n";
-            cout << " 17. Sort: By Name (Quick Sort)\n";
-            cout << " 18. Sort: By Name (Radix Sort)\n";
-            cout << " 19. Back to Drive\n";
-            PrintLine();
-            
-            int ch = InputInt(" Select Action: ", 1, 19);
-            
-            switch(ch) {
-                case 1: CreateFile(); break;
-                case 2: files.DisplayAll(); break;
-                case 3: SearchFile(); break;
-                case 4: DeleteFile(); break;
-                case 5: deletedFiles.Display(); break;
-                case 6: RecoverFile(); break;
-                case 7: recentFiles.Display(); break;
-                case 8: starredFiles.DisplayTop(); break;
-                case 9: BrowseFiles(); break;
-                case 10: ViewFileVersions(); break;
-                case 11: files.SortBubbleSize(); break;
-                case 12: files.SortInsertionSize(); break;
-                case 13: files.SortSelectionSize(); break;
-                case 14: files.SortMergeSize(); break;
-                case 15: files.SortHeapSize(); break;
-                case 16: files.SortCountingSize(); break;
-                case 17: files.SortQuickName(); break;
-                case 18: files.SortRadixName(); break;
-                case 19: return;
-            }
-            
-            cout << "\n (Press Enter to continue...)";
-            cin.get(); 
+    /**
+     * @brief  Friends of friends for a user, ranked by mutual friends.
+     * @return Best first; empty for an unknown user.
+     */
+    vector<FriendRecommender::Recommendation> RecommendFriends(const string &user, size_t k = RECOMMEND_LIMIT) {
+        uint32_t id = users.Find(user);
+        if (id == UserDirectory::NO_USER) return {};
+        return recommender.Recommend(adj, id, k);
+    }
+
+    void RecommendFriends(User* currentUser) {
+        vector<FriendRecommender::Recommendation> recs = RecommendFriends(currentUser->GetName());
+
+        cout << "\n --- FRIEND RECOMMENDATIONS (Mutual Friends) ---\n";
+        if (recs.empty()) {
+            cout << " No suggestions available.\n";
+            return;
+        }
+        for (const FriendRecommender::Recommendation& r : recs) {
+            cout << " Suggestion: " << users.Get(r.id)->GetName() << " (" << r.mutual << " mutual friend"
+                 << (r.mutual == 1 ? "" : "s") << ")\n";
         }
     }
 
-    File* GetFileById(int fid) { return files.Search(fid); }
-};
+    // Everyone reachable from a user through friendships, the user excluded
+    vector<uint32_t> ConnectedUsers(const string &user) {
+        vector<uint32_t> out;
+        uint32_t id = users.Find(user);
+        if (id == UserDirectory::NO_USER) return out;
+        FriendComponents& c = Components();
+        out.reserve(c.ComponentSize(id) - 1);
+        c.ForEachMember(id, [&](uint32_t v) {
+            if (v != id) out.push_back(v);
+        });
+        return out;
+    }
 
-class TreeNode {
-public:
-    Folder data;
-    TreeNode* left;
-    TreeNode* right;
-    int height;
-    TreeNode(Folder f) : data(f), left(nullptr), right(nullptr), height(1) {}
-};
+    // Size of a user's network, the user included; 0 for an unknown user
+    uint32_t NetworkSize(const string &user) {
+        uint32_t id = users.Find(user);
+        return id == UserDirectory::NO_USER ? 0 : Components().ComponentSize(id);
+    }
 
-class AVLTreeFolders {
-private:
-    TreeNode* root;
-
-    int Height(TreeNode* n) { return n ? n->height : 0; }
-    int BalanceFactor(TreeNode* n) { return Height(n->left) - Height(n->right); }
-
-    TreeNode* RotateRight(TreeNode* y) {
-        if (!y || !y->left) return y;  // Safety check
-        TreeNode* x = y->left;
-        TreeNode* T2 = x->right;
-        x->right = y; 
-        y->left = T2;
-        y->height = max(Height(y->left), Height(y->right)) + 1;
-        x->height = max(Height(x->left), Height(x->right)) + 1;
-        return x;
+    void FindConnectedComponents(User* currentUser) {
+        vector<uint32_t> component = ConnectedUsers(currentUser->GetName());
+
+        cout << "\n --- CONNECTED USERS (Union-Find) ---\n";
+        if (component.empty()) {
+            cout << " No connected users found.\n";
+            return;
+        }
+        cout << " Your connected network includes " << component.size() << " user(s):\n";
+        for (uint32_t id : component) cout << " - " << users.Get(id)->GetName() << endl;
     }
 
-    TreeNode* RotateLeft(TreeNode* x) {
-        if (!x || !x->right) return x;  // Safety check
-        TreeNode* y = x->right;
-        TreeNode* T2 = y->left;
-        y->left = x; 
-        x->right = T2;
-        x->height = max(Height(x->left), Height(x->right)) + 1;
-        y->height = max(Height(y->left), Height(y->right)) + 1;
-        return y;
+    /**
+     * @brief  Runs the analytics batch job on every core and keeps the
+     *         report for the dashboard. The BFS starts at source, if given.
+     */
+    const GraphAnalytics::Report& RunAnalytics(const string &source = "") {
+        vector<bool> live(users.Bound(), false);
+        users.ForEach([&live](User& u) { live[u.GetID()] = true; });
+        lastReport = GraphAnalytics::Analyze(adj, live, users.Find(source));
+        sysLog.Log("Analytics", "Network analytics on " + to_string(lastReport.threads) + " threads");
+        return lastReport;
+    }
+
+    void ShowAnalytics(User* currentUser) {
+        PrintHeader("NETWORK ANALYTICS");
+        if (lastReport.computedAt == 0) {
+            cout << " No report yet; running the analytics job...\n";
+            RunAnalytics(currentUser->GetName());
+        } else {
+            string ts = ctime(&lastReport.computedAt);
+            cout << " Last report: " << ts.substr(0, ts.size() - 1) << " (" << lastReport.friendships
+                 << " friendships then, " << adj.EdgeCount() << " now)\n";
+            string again = InputString(" Run the job again? (y/n): ");
+            if (again == "y" || again == "Y") RunAnalytics(currentUser->GetName());
+        }
+
+        const GraphAnalytics::Report& r = lastReport;
+        cout << fixed << setprecision(1);
+        cout << "\n Computed on " << r.threads << " thread(s): degrees " << r.degreeMillis << " ms, components "
+             << r.componentMillis << " ms, BFS " << r.bfsMillis << " ms\n";
+        cout << "\n --- DEGREES ---\n";
+        cout << " Users: " << r.users << "   Friendships: " << r.friendships << "   Without friends: " << r.isolated << "\n";
+        cout << " Mean friends: " << setprecision(2) << r.meanDegree << "   Most friends: " << r.maxDegree << "\n";
+        for (size_t b = 0; b < r.degreeBuckets.size(); b++) {
+            if (b == 0) cout << "   0 friends      : ";
+            else cout << "   " << setw(5) << (1ULL << (b - 1)) << "-" << setw(6) << left << ((1ULL << b) - 1) << right << " : ";
+            cout << r.degreeBuckets[b] << "\n";
+        }
+        cout << " Best connected:\n";
+        for (const auto& h : r.hubs) {
+            User* u = users.Get(h.first);
+            if (u) cout << " - " << u->GetName() << " (" << h.second << " friends)\n";
+        }
+        cout << "\n --- COMPONENTS ---\n";
+        cout << " Separate networks: " << r.components << "   Largest: " << r.largestComponent << " users\n";
+        User* src = users.Get(r.source);
+        if (src) {
+            cout << "\n --- REACH OF " << src->GetName() << " (BFS) ---\n";
+            for (size_t d = 1; d < r.levelSizes.size(); d++) cout << " " << d << " hop(s) away: " << r.levelSizes[d] << "\n";
+            cout << " Reachable: " << r.reached - 1 << "   Mean distance: " << setprecision(2) << r.meanDistance << "\n";
+        }
+        cout << defaultfloat;
+    }
+
+    /**
+     * @brief  Up to k shortest loop-free friendship paths between two users,
+     *         each at most maxHops long; shortest first.
+     * @return Empty if either user is unknown or they are not connected.
+     */
+    vector<PathFinder::Path> FindPaths(const string &from, const string &to, size_t k = 1,
+                                       uint32_t maxHops = PATH_MAX_HOPS) {
+        uint32_t a = users.Find(from);
+        uint32_t b = users.Find(to);
+        if (a == UserDirectory::NO_USER || b == UserDirectory::NO_USER) return {};
+        if (k == 1) {
+            PathFinder::Path p = pathFinder.Shortest(adj, a, b, maxHops);
+            return p.empty() ? vector<PathFinder::Path>() : vector<PathFinder::Path>(1, p);
+        }
+        return pathFinder.KShortest(adj, a, b, k, maxHops);
+    }
+
+    void FindPathBetweenUsers(User* currentUser) {
+        string targetName = InputString(" Enter target username: ");
+        uint32_t endNode = users.Find(targetName);
+
+        if (endNode == UserDirectory::NO_USER) {
+            cout << " [ERROR] Invalid user(s).\n";
+            return;
+        }
+
+        if (currentUser->GetID() == endNode) {
+            cout << " [INFO] Same user selected.\n";
+            return;
+        }
+
+        int k = InputInt(" How many paths (1 = shortest only): ", 1, PATH_QUERY_LIMIT);
+        vector<PathFinder::Path> paths = FindPaths(currentUser->GetName(), targetName, k);
+
+        cout << "\n --- PATHS BETWEEN USERS (Bidirectional BFS, up to " << PATH_MAX_HOPS << " hops) ---\n";
+        if (paths.empty()) {
+            cout << " No path found between " << currentUser->GetName() << " and " << targetName << ".\n";
+        } else {
+            cout << " Found " << paths.size() << " path(s):\n";
+            for (size_t i = 0; i < paths.size(); i++) {
+                cout << " Path " << (i+1) << " (" << paths[i].size() - 1 << " hops): ";
+                for (size_t j = 0; j < paths[i].size(); j++) {
+                    cout << users.Get(paths[i][j])->GetName();
+                    if (j < paths[i].size() - 1) cout << " -> ";
+                }
+                cout << endl;
+            }
+        }
     }
 
-    TreeNode* Insert(TreeNode* node, Folder f) {
-        if (!node) return new TreeNode(f);
+    // --- FILE SHARING LOGIC ---
 
-        if (f.GetID() < node->data.GetID())
-            node->left = Insert(node->left, f);
-        else if (f.GetID() > node->data.GetID())
-            node->right = Insert(node->right, f);
-        else return node; // No duplicates
+    /**
+     * @brief  Copies a file into the receiver's "Shared with Me" folder.
+     * @return false if the receiver, folder or file does not exist.
+     */
+    bool ShareFile(User* sender, const string &targetName, int folderID, int fileID) {
+        User* receiver = users.FindUser(targetName);
+        if (!receiver) return false;
 
-        node->height = 1 + max(Height(node->left), Height(node->right));
-        int balance = BalanceFactor(node);
+        Folder* srcFolder = sender->GetFolder(folderID);
+        if(!srcFolder) return false;
+        File* file = srcFolder->GetFileById(fileID);
+        if(!file) return false;
+        
+        // The copy shares the file's version history, so no content is duplicated
+        SharedFolderOf(receiver)->InsertSharedFile(*file);
+        
+        receiver->AddNotification("User " + sender->GetName() + " shared file: " + file->GetName());
+        sysLog.Log("Share", sender->GetName() + " shared " + file->GetName() + " with " + targetName);
+        journal.Append(JournalRecord(JOP_SHARE_FILE).Str(sender->GetName()).Str(targetName).Int(folderID).Int(fileID));
+        return true;
+    }
 
-        // Left Left
-        if (balance > 1 && node->left && f.GetID() < node->left->data.GetID())
-            return RotateRight(node);
-        // Right Right
-        if (balance < -1 && node->right && f.GetID() > node->data.GetID())
-            return RotateLeft(node);
-        // Left Right
-        if (balance > 1 && node->left && f.GetID() > node->left->data.GetID()) {
-            node->left = RotateLeft(node->left);
-            return RotateRight(node);
+    /**
+     * @brief  Shares several files of one folder with several users in one
+     *         pass: each file is looked up once and each receiver's shared
+     *         folder once. Receivers get references to the sender's version
+     *         history; whoever edits a shared file first starts their own
+     *         newer versions and leaves everyone else's untouched.
+     * @return Number of users the files went to; 0 (and nothing shared) if a
+     *         file or user does not exist.
+     */
+    int ShareFiles(User* sender, int folderID, const vector<int> &fileIDs, const vector<string> &targets) {
+        Folder* srcFolder = sender->GetFolder(folderID);
+        if (!srcFolder || fileIDs.empty()) return 0;
+        vector<File*> sources;
+        for (int id : fileIDs) {
+            File* f = srcFolder->GetFileById(id);
+            if (!f) return 0;
+            sources.push_back(f);
         }
-        // Right Left
-        if (balance < -1 && node->right && f.GetID() < node->right->data.GetID()) {
-            node->right = RotateRight(node->right);
-            return RotateLeft(node);
+        vector<User*> receivers;
+        vector<bool> picked(users.Bound(), false);
+        for (const string &name : targets) {
+            User* u = users.FindUser(name);
+            if (!u) return 0;
+            if (picked[u->GetID()]) continue;
+            picked[u->GetID()] = true;
+            receivers.push_back(u);
         }
-        return node;
-    }
-
-    void InOrderDisplay(TreeNode* root) {
-        if(root) {
-            InOrderDisplay(root->left);
-            cout << " [ID: " << setw(3) << root->data.GetID() << "] " << root->data.GetName() << "\n";
-            InOrderDisplay(root->right);
+        if (receivers.empty()) return 0;
+
+        string what = sources.size() == 1 ? "file: " + sources[0]->GetName()
+                                           : to_string(sources.size()) + " files from " + srcFolder->GetName();
+        for (User* receiver : receivers) {
+            Folder* sharedFolder = SharedFolderOf(receiver);
+            for (File* f : sources) sharedFolder->InsertSharedFile(*f);
+            receiver->AddNotification("User " + sender->GetName() + " shared " + what);
         }
-    }
 
-    TreeNode* Search(TreeNode* root, int id) {
-        if (!root || root->data.GetID() == id) return root;
-        if (id < root->data.GetID()) return Search(root->left, id);
-        return Search(root->right, id);
+        sysLog.Log("Share", sender->GetName() + " shared " + what + " with " + to_string(receivers.size()) + " user(s)");
+        JournalRecord rec(JOP_SHARE_BATCH);
+        rec.Str(sender->GetName()).Int(folderID).Int(fileIDs.size());
+        for (int id : fileIDs) rec.Int(id);
+        rec.Int(receivers.size());
+        for (User* u : receivers) rec.Str(u->GetName());
+        journal.Append(rec);
+        return receivers.size();
     }
 
-private:
-    // Helper function to delete all nodes recursively
-    void DeleteTree(TreeNode* node) {
-        if (node) {
-            DeleteTree(node->left);
-            DeleteTree(node->right);
-            delete node;
-        }
+    // Same as above with every current friend of the sender
+    int ShareWithFriends(User* sender, int folderID, const vector<int> &fileIDs) {
+        vector<string> names;
+        adj.ForEachNeighbor(sender->GetID(), [&](uint32_t v) { names.push_back(users.Get(v)->GetName()); });
+        return ShareFiles(sender, folderID, fileIDs, names);
     }
 
-public:
-    AVLTreeFolders() : root(nullptr) {}
-    
-    // Destructor - CRITICAL: Prevents memory leaks
-    ~AVLTreeFolders() {
-        DeleteTree(root);
-        root = nullptr;
-    }
-    
-    // Copy constructor - CRITICAL: Prevents shallow copy issues
-    AVLTreeFolders(const AVLTreeFolders& other) : root(nullptr) {
-        if (other.root) {
-            root = CopyTree(other.root);
-        }
-    }
-    
-    // Copy assignment operator
-    AVLTreeFolders& operator=(const AVLTreeFolders& other) {
-        if (this != &other) {
-            DeleteTree(root);
-            root = nullptr;
-            if (other.root) {
-                root = CopyTree(other.root);
+    void ShareFile(User* sender) {
+        string line = InputString(" Share with (usernames separated by spaces, or @friends): ");
+        vector<string> targets;
+        stringstream names(line);
+        for (string name; names >> name;) targets.push_back(name);
+        bool toFriends = targets.size() == 1 && targets[0] == "@friends";
+        if (targets.empty() || (toFriends && FriendCount(sender->GetID()) == 0)) { cout << " No one to share with.\n"; return; }
+        if (!toFriends) {
+            for (const string &name : targets) {
+                if (!users.FindUser(name)) { cout << " User '" << name << "' not found.\n"; return; }
             }
         }
-        return *this;
-    }
-    
-    // Helper to copy tree recursively - creates new nodes
-    TreeNode* CopyTree(TreeNode* source) {
-        if (!source) return nullptr;
-        TreeNode* newNode = new TreeNode(source->data);  // Copy folder data
-        newNode->left = CopyTree(source->left);
-        newNode->right = CopyTree(source->right);
-        newNode->height = source->height;
-        return newNode;
-    }
-
-    void AddFolder(Folder f) {
-        if (root) {
-            // Check for duplicate ID before inserting
-            TreeNode* existing = Search(root, f.GetID());
-            if (existing) {
-                cout << " [WARNING] Folder with ID " << f.GetID() << " already exists. Skipping.\n";
-                return;
-            }
+        
+        // Select File
+        sender->GetFolderTree()->DisplayAll();
+        int folderID = InputInt(" Select source Folder ID: ");
+        Folder* srcFolder = sender->GetFolder(folderID);
+        
+        if(!srcFolder) { cout << " Invalid folder.\n"; return; }
+        
+        // We need a way to list files - for now, just ask for file ID
+        // In a real implementation, we'd have a method to list files
+        cout << "\n Note: You'll need to know the File ID from the folder.\n";
+        vector<int> fileIDs;
+        stringstream ids(InputString(" Enter File ID(s) to share, separated by spaces: "));
+        for (int id; ids >> id;) {
+            if (!srcFolder->GetFileById(id)) { cout << " File " << id << " not found.\n"; return; }
+            fileIDs.push_back(id);
+        }
+        if (fileIDs.empty()) { cout << " No files selected.\n"; return; }
+        
+        int sent = toFriends ? ShareWithFriends(sender, folderID, fileIDs) : ShareFiles(sender, folderID, fileIDs, targets);
+        if (sent > 0) {
+            cout << " [SUCCESS] Shared " << fileIDs.size() << " file(s) with " << sent
+                 << " user(s). They appear in each 'Shared with Me' folder without copying any content.\n";
         }
-        root = Insert(root, f);
     }
+};
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file (buffered read on Windows).
+ */
+class MappedFile {
+private:
+    const char* data;
+    size_t size;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
 
-    Folder* GetFolder(int id) {
-        if (!root) return nullptr;  // Safety check
-        TreeNode* res = Search(root, id);
-        return res ? &res->data : nullptr;
+public:
+    MappedFile() : data(nullptr), size(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const string& path) {
+        Close();
+#ifdef _WIN32
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in) return false;
+        buffer.resize((size_t)in.tellg());
+        in.seekg(0);
+        in.read(buffer.data(), buffer.size());
+        data = buffer.data();
+        size = buffer.size();
+        return (bool)in;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);  // The mapping stays valid after the descriptor is closed
+        if (p == MAP_FAILED) return false;
+        data = (const char*)p;
+        size = (size_t)st.st_size;
+        return true;
+#endif
     }
 
-    void DisplayAll() {
-        if(!root) {
-            cout << " No folders yet.\n";
-        } else {
-            cout << " --- FOLDER LIST (In-Order) ---\n";
-            InOrderDisplay(root);
-        }
+    void Close() {
+#ifdef _WIN32
+        buffer.clear();
+#else
+        if (data) munmap((void*)data, size);
+#endif
+        data = nullptr;
+        size = 0;
     }
+
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
 };
 
-const int ALPHABET_SIZE = 26;
+const string SNAPSHOT_FILE = "drive.snap";
+const uint32_t SNAPSHOT_FORMAT_VERSION = 10;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+/*
+ * Snapshot layout (all records fixed-size and 8-byte aligned, so every
+ * section can be read straight out of the mapping while the drive is
+ * rebuilt from it):
+ *
+ *   SnapHeader
+ *   SnapUser[userCount]        live users, ascending user ID
+ *   SnapFolder[folderCount]    each user's folders, ascending ID
+ *   SnapFile[fileCount]        each folder's files, grouped by list
+ *   SnapVersion[versionCount]  every distinct version once, each after the older one it links to
+ *                              (files shared from one another point into the same chains)
+ *   SnapStr[noteCount]         each user's notifications, oldest first
+ *   SnapEdge[edgeCount]        friendships by user ID (a < b)
+ *   SnapChunk[chunkCount]      the chunk store, one record per unique chunk
+ *   uint32[chunkRefCount]      keyframe chunk lists, as indexes into SnapChunk
+ *   uint32[retiredCount]       IDs of deleted users, ascending; with the live
+ *                              users they cover [0, userIDBound) exactly
+ *   heap                       string, delta and chunk bytes
+ */
+struct SnapStr {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t reserved;
+};
 
-struct TrieNode {
-    TrieNode *children[ALPHABET_SIZE];
-    bool isEndOfWord;
-    
-    TrieNode() {
-        isEndOfWord = false;
-        for (int i = 0; i < ALPHABET_SIZE; i++)
-            children[i] = nullptr;
-    }
+struct SnapHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint64_t userCount, folderCount, fileCount, versionCount, noteCount, edgeCount;
+    uint64_t userOffset, folderOffset, fileOffset, versionOffset, noteOffset, edgeOffset;
+    uint64_t heapOffset, heapSize;
+    uint64_t journalLsn;  // Last journal record already reflected in this snapshot
+    uint64_t chunkCount, chunkRefCount, chunkOffset, chunkRefOffset;
+    uint64_t recentCount, recentOffset;
+    uint64_t userIDBound;  // IDs below this were handed out, even if their users are gone
+    uint64_t retiredCount, retiredOffset;
 };
 
-class TrieUsers {
-private:
-    TrieNode *root;
+struct SnapUser {
+    SnapStr name, password, securityQ, securityA;
+    int32_t folderCounter;
+    uint32_t folderCount;
+    uint32_t noteCount;
+    uint32_t trashCapacity;
+    int64_t trashRetention;
+    uint32_t id;
+    uint32_t reserved;
+};
 
-public:
-    TrieUsers() { root = new TrieNode(); }
-
-    void Insert(string key) {
-        TrieNode *pCrawl = root;
-        for (int i = 0; i < key.length(); i++) {
-            int index = tolower(key[i]) - 'a';
-            if (index < 0 || index >= 26) continue; // Skip non-alpha for simplicity
-            if (!pCrawl->children[index])
-                pCrawl->children[index] = new TrieNode();
-            pCrawl = pCrawl->children[index];
-        }
-        pCrawl->isEndOfWord = true;
-    }
-
-    bool Search(string key) {
-        TrieNode *pCrawl = root;
-        for (int i = 0; i < key.length(); i++) {
-            int index = tolower(key[i]) - 'a';
-            if (index < 0 || index >= 26) return false;
-            if (!pCrawl->children[index])
-                return false;
-            pCrawl = pCrawl->children[index];
-        }
-        return (pCrawl != nullptr && pCrawl->isEndOfWord);
-    }
-    
-    // Helper for autocomplete suggestion
-    void SuggestHelper(TrieNode* root, string currPrefix) {
-        if (!root) return;  // Safety check
-        if (root->isEndOfWord) {
-            cout << " - " << currPrefix << endl;
-        }
-        for (int i = 0; i < ALPHABET_SIZE; i++) {
-            if (root->children[i]) {
-                char child = 'a' + i;
-                SuggestHelper(root->children[i], currPrefix + child);
-            }
-        }
-    }
+struct SnapFolder {
+    SnapStr name;
+    int32_t id;
+    int32_t fileIDCounter;
+    uint32_t fileCount;
+    uint32_t recentCount;
+};
 
-    void AutoComplete(string prefix) {
-        TrieNode *pCrawl = root;
-        for (int i = 0; i < prefix.length(); i++) {
-            int index = tolower(prefix[i]) - 'a';
-            if (!pCrawl->children[index]) {
-                cout << " No users found with prefix '" << prefix << "'.\n";
-                return;
-            }
-            pCrawl = pCrawl->children[index];
-        }
-        cout << " Suggestions for '" << prefix << "':\n";
-        SuggestHelper(pCrawl, prefix);
-    }
+// Which container of the folder a file record belongs to (SNAP_RECENT and SNAP_STARRED are no longer written)
+enum SnapFileList : uint8_t { SNAP_LIVE, SNAP_TRASH, SNAP_RECENT, SNAP_STARRED };
+
+struct SnapRecent {
+    int32_t fileID;
+    uint32_t reserved;
+    int64_t accessedAt;
 };
-class User {
-private:
-    string username;
-    string password;
-    string securityQ;
-    string securityA;
-    AVLTreeFolders myFolders;
-    int folderCounter;
-    CircularNotificationQueue notifications;  // Changed from vector to Circular Linked List
 
-public:
-    User() : folderCounter(1) {}
+struct SnapFile {
+    SnapStr name, type, owner;
+    int64_t sizeBytes;
+    int64_t deletedAt;  // Trash entries only
+    int32_t id;
+    int32_t priority;
+    uint32_t versionCount;
+    uint8_t list;
+    uint8_t reserved[3];
+    uint32_t newestVersion;  // Index into the version section, or SNAP_NO_VERSION
+    uint32_t reserved2;
+};
 
-    void Setup(string u, string p, string sq, string sa) {
-        username = u;
-        password = p;
-        securityQ = sq;
-        securityA = sa;
-    }
+const uint32_t SNAP_NO_VERSION = UINT32_MAX;
+
+struct SnapVersion {
+    SnapStr timestamp;
+    SnapStr delta;
+    int32_t versionNumber;
+    uint8_t isKeyframe;
+    uint8_t codec;
+    uint8_t reserved[2];
+    uint32_t chunkCount;  // Keyframes: how many entries of the chunk-ref section follow
+    uint32_t deltaSize;   // Deltas: uncompressed size
+    uint32_t older;       // Index of the previous version, or SNAP_NO_VERSION
+    uint32_t reserved2;
+};
 
-    bool CheckPassword(string p) { return password == p; }
-    string GetName() const { return username; }
-    string GetSecQ() const { return securityQ; }
-    bool CheckSecA(string a) { return securityA == a; }
-    void SetPassword(string p) { password = p; }
+struct SnapEdge {
+    uint32_t a, b;
+};
 
-    void CreateFolder() {
-        string fname = InputString(" Enter new folder name: ");
-        if (fname.empty()) {
-            cout << " [ERROR] Folder name cannot be empty.\n";
-            return;
-        }
-        
-        Folder f;
-        f.SetValues(fname, folderCounter, username);
-        myFolders.AddFolder(f);
-        cout << " [SUCCESS] Folder '" << fname << "' created (ID: " << folderCounter << ").\n";
-        sysLog.Log("FolderCreate", username + " created folder " + fname);
-        folderCounter++;
+struct SnapChunk {
+    uint8_t hash[32];
+    SnapStr data;      // Compressed bytes
+    uint32_t rawSize;
+    uint8_t codec;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(SnapStr) == 16 && sizeof(SnapUser) == 96 && sizeof(SnapFolder) == 32 &&
+              sizeof(SnapFile) == 88 && sizeof(SnapVersion) == 56 && sizeof(SnapEdge) == 8 &&
+              sizeof(SnapChunk) == 56 && sizeof(SnapRecent) == 16,
+              "Snapshot records must keep their on-disk size");
+
+/**
+ * @class DriveSnapshot
+ * @brief Saves and loads the whole drive as one versioned binary file.
+ *
+ * Loading is a full rebuild, not a view of the mapping: every user, folder
+ * and file is allocated, strings are copied out and tables and indexes are
+ * rebuilt, so it costs O(files). The mapping is closed once Load returns.
+ */
+class DriveSnapshot {
+private:
+    // --- WRITING ---
+    vector<SnapUser> users;
+    vector<SnapFolder> folders;
+    vector<SnapFile> files;
+    vector<SnapRecent> recents;
+    vector<SnapVersion> versions;
+    vector<SnapStr> notes;
+    vector<SnapEdge> edges;
+    vector<SnapChunk> chunks;
+    vector<uint32_t> chunkRefs;
+    vector<uint32_t> retired;
+    vector<uint32_t> chunkSlot;  // Chunk-store ID -> index in chunks
+    unordered_map<const VersionNode*, uint32_t> versionSlot;  // Versions already written
+    string heap;
+
+    SnapStr Put(const string& s) {
+        SnapStr ref = {heap.size(), (uint32_t)s.size(), 0};
+        heap += s;
+        return ref;
     }
 
-    void OpenFolder() {
-        myFolders.DisplayAll();
-        int fid = InputInt(" Enter Folder ID to open: ");
-        Folder* f = myFolders.GetFolder(fid);
-        if(f) {
-            f->ShowMenu();
-        } else {
-            cout << " [ERROR] Invalid Folder ID.\n";
+    void PutFile(const File& f, SnapFileList list, int64_t deletedAt = 0) {
+        SnapFile rec = {};
+        rec.name = Put(f.name);
+        rec.type = Put(f.type);
+        rec.owner = Put(f.owner);
+        rec.sizeBytes = f.sizeBytes;
+        rec.deletedAt = deletedAt;
+        rec.id = f.id;
+        rec.priority = f.priority;
+        rec.list = list;
+
+        // Only versions no earlier file has written; shared histories are stored once
+        vector<const VersionNode*> fresh;
+        uint32_t older = SNAP_NO_VERSION;
+        for (const VersionNode* n = f.versions.head.get(); n; n = n->next.get()) {
+            auto it = versionSlot.find(n);
+            if (it != versionSlot.end()) {
+                older = it->second;
+                break;
+            }
+            fresh.push_back(n);
+        }
+        for (auto it = fresh.rbegin(); it != fresh.rend(); ++it) {
+            const FileVersion& data = (*it)->data;
+            SnapVersion v = {};
+            v.timestamp = Put(data.timestamp);
+            v.delta = Put(data.content);
+            v.versionNumber = data.versionNumber;
+            v.isKeyframe = data.isKeyframe;
+            v.codec = data.codec;
+            v.deltaSize = data.deltaSize;
+            for (uint32_t id : data.chunks.IDs()) chunkRefs.push_back(chunkSlot[id]);
+            v.chunkCount = data.chunks.IDs().size();
+            v.older = older;
+            older = versions.size();
+            versionSlot[*it] = older;
+            versions.push_back(v);
         }
+        rec.newestVersion = older;
+        rec.versionCount = f.versions.count;
+        files.push_back(rec);
     }
 
-    void AddNotification(string msg) {
-        notifications.AddNotification("[" + CurrentTimestamp() + "] " + msg);
+    void PutFolder(Folder& folder) {
+        SnapFolder rec = {};
+        rec.name = Put(folder.name);
+        rec.id = folder.id;
+        rec.fileIDCounter = folder.fileIDCounter;
+        size_t firstFile = files.size();
+
+        folder.files.ForEach([this](File& f) { PutFile(f, SNAP_LIVE); });
+        folder.deletedFiles.ForEach([this](const File& f, int64_t deletedAt) { PutFile(f, SNAP_TRASH, deletedAt); });
+        folder.recentFiles.ForEach([this](const RecentFiles::Access& a) {
+            recents.push_back({a.fileID, 0, a.accessedAt});  // Newest first
+        });
+        rec.recentCount = folder.recentFiles.Size();
+
+        rec.fileCount = files.size() - firstFile;
+        folders.push_back(rec);
     }
 
-    void ShowNotifications() {
-        PrintHeader("NOTIFICATIONS");
-        notifications.DisplayAll();
-        PrintLine();
+    void CollectFolders(User& user, SnapUser& rec) {
+        user.myFolders.ForEach([&](Folder& folder) {
+            PutFolder(folder);
+            rec.folderCount++;
+        });
     }
-    
-    // Needed for sharing
-    Folder* GetFolder(int id) { return myFolders.GetFolder(id); }
-    AVLTreeFolders* GetFolderTree() { return &myFolders; }
-};
 
-class UserGraph {
-private:
-    vector<User*> users;
-    vector<vector<int>> adj; // Adjacency Matrix
-    TrieUsers userTrie; // For fast search
+    static uint64_t Align8(uint64_t x) { return (x + 7) & ~uint64_t(7); }
 
-    int GetUserIndex(string name) {
-        for(size_t i=0; i<users.size(); i++) {
-            if(users[i]->GetName() == name) return i;
+    // Sections are written in file order, so the writer only ever pads forward
+    struct SnapWriter {
+        FILE* f;
+        uint64_t pos;
+        bool ok;
+
+        void Write(const void* data, size_t n) {
+            if (ok && n && fwrite(data, 1, n, f) != n) ok = false;
+            pos += n;
         }
-        return -1;
+
+        void PadTo(uint64_t offset) {
+            static const char zeros[8] = {};
+            while (pos < offset) Write(zeros, (size_t)min<uint64_t>(sizeof(zeros), offset - pos));
+        }
+    };
+
+    template <typename T>
+    static void WriteSection(SnapWriter& out, const vector<T>& v, uint64_t offset) {
+        out.PadTo(offset);
+        out.Write(v.data(), v.size() * sizeof(T));
     }
 
-public:
-    UserGraph() {}
+    // Flushes, syncs and closes f, reporting any failure along the way
+    static bool CloseDurably(FILE* f) {
+        bool ok = fflush(f) == 0;
+#ifdef _WIN32
+        ok = ok && _commit(_fileno(f)) == 0;
+#else
+        ok = ok && fsync(fileno(f)) == 0;
+#endif
+        return (fclose(f) == 0) && ok;
+    }
 
-    void RegisterUser() {
-        PrintHeader("NEW USER REGISTRATION");
-        string u = InputString(" Choose Username: ");
-        if(userTrie.Search(u)) {
-            cout << " [ERROR] Username taken.\n";
-            return;
-        }
+    // Makes a rename inside path's directory survive a crash
+    static bool SyncParentDir(const string& path) {
+#ifdef _WIN32
+        (void)path;
+        return true;
+#else
+        size_t slash = path.find_last_of('/');
+        string dir = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        int fd = open(dir.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        bool ok = fsync(fd) == 0;
+        return (close(fd) == 0) && ok;
+#endif
+    }
 
-        string p = InputString(" Choose Password: ");
-        string sq = InputString(" Security Question: ");
-        string sa = InputString(" Security Answer: ");
+    // --- READING ---
+    const char* base;
+    const SnapHeader* header;
+    bool corrupt;
+    vector<uint32_t> chunkIDs;  // Snapshot chunk index -> chunk-store ID
+    vector<shared_ptr<VersionNode>> versionNodes;  // Snapshot version index -> node
+    vector<uint32_t> versionDepth;                 // Versions in the chain ending at each node
+
+    string Get(const SnapStr& ref) {
+        if (ref.offset + ref.length > header->heapSize) {
+            corrupt = true;
+            return "";
+        }
+        return string(base + header->heapOffset + ref.offset, ref.length);
+    }
 
-        User* newUser = new User();
-        newUser->Setup(u, p, sq, sa);
-        
-        users.push_back(newUser);
-        // Expand Adjacency Matrix
-        for(auto& row : adj) row.push_back(0); // Add col to existing rows
-        adj.push_back(vector<int>(users.size(), 0)); // Add new row
-        
-        userTrie.Insert(u);
-        sysLog.Log("UserRegister", "New user registered: " + u);
-        cout << " [SUCCESS] User registered!\n";
+    // Frees whatever a failed load managed to build
+    static void Discard(UserGraph& graph) {
+        graph.users.Clear();
+        graph.adj.Clear();
+        graph.components = FriendComponents();
+        graph.userTrie = TrieUsers();
+        chunkStore.PurgeUnreferenced();
     }
 
-    User* Login() {
-        PrintHeader("LOGIN");
-        string u = InputString(" Username: ");
-        int idx = GetUserIndex(u);
-        if(idx == -1) {
-            cout << " [ERROR] User not found.\n";
+    template <typename T>
+    const T* Section(uint64_t offset, uint64_t count, size_t fileSize) {
+        if (offset % 8 != 0 || offset > fileSize || count > (fileSize - offset) / sizeof(T)) {
+            corrupt = true;
             return nullptr;
         }
-        
-        string p = InputString(" Password: ");
-        if(users[idx]->CheckPassword(p)) {
-            sysLog.Log("Login", "User " + u + " logged in.");
-            return users[idx];
-        } else {
-            cout << " [ERROR] Incorrect password.\n";
-            return nullptr;
+        return (const T*)(base + offset);
+    }
+
+    /**
+     * @brief  Rebuilds every version node, each linked to the older one it
+     *         names; files then pick up their newest node.
+     * @return false if a version links forward or out of range.
+     */
+    bool LoadVersions(const SnapVersion* v, uint64_t count, const uint32_t* ref) {
+        versionNodes.resize(count);
+        versionDepth.resize(count);
+        for (uint64_t i = 0; i < count; i++, v++) {
+            if (v->older != SNAP_NO_VERSION && v->older >= i) return false;
+            if (v->codec >= CODEC_COUNT) return false;
+            CodecID codec = (CodecID)v->codec;
+            if (v->isKeyframe) {
+                ChunkList list;
+                for (uint32_t k = 0; k < v->chunkCount; k++, ref++) {
+                    if (*ref >= chunkIDs.size()) return false;
+                    chunkStore.AddRef(chunkIDs[*ref]);
+                    list.Append(chunkIDs[*ref]);
+                }
+                versionNodes[i] = make_shared<VersionNode>(FileVersion(v->versionNumber, move(list), codec));
+            } else {
+                versionNodes[i] = make_shared<VersionNode>(FileVersion(v->versionNumber, Get(v->delta), v->deltaSize, codec));
+            }
+            versionNodes[i]->data.timestamp = Get(v->timestamp);
+            if (v->older != SNAP_NO_VERSION) versionNodes[i]->next = versionNodes[v->older];
+            versionDepth[i] = v->older == SNAP_NO_VERSION ? 1 : versionDepth[v->older] + 1;
         }
+        return true;
     }
-    
-    void RecoverAccount() {
-        string u = InputString(" Enter Username to recover: ");
-        int idx = GetUserIndex(u);
-        if(idx == -1) { cout << " User not found.\n"; return; }
-        
-        cout << " Security Question: " << users[idx]->GetSecQ() << endl;
-        string ans = InputString(" Answer: ");
-        if(users[idx]->CheckSecA(ans)) {
-            string newP = InputString(" Enter New Password: ");
-            users[idx]->SetPassword(newP);
-            cout << " [SUCCESS] Password reset.\n";
-            sysLog.Log("PassReset", "Password reset for " + u);
+
+    File LoadFile(const SnapFile& rec) {
+        File f;
+        f.id = rec.id;
+        f.name = Get(rec.name);
+        f.type = Get(rec.type);
+        f.owner = Get(rec.owner);
+        f.sizeBytes = rec.sizeBytes;
+        f.priority = rec.priority;
+        if (rec.newestVersion == SNAP_NO_VERSION) {
+            if (rec.versionCount != 0) corrupt = true;
+        } else if (rec.newestVersion >= versionNodes.size() || versionDepth[rec.newestVersion] != rec.versionCount) {
+            corrupt = true;
         } else {
-            cout << " [ERROR] Wrong answer.\n";
+            f.versions.head = versionNodes[rec.newestVersion];
+            f.versions.count = rec.versionCount;
         }
+        return f;
     }
 
-    // --- FRIENDSHIP & GRAPH ALGORITHMS ---
+public:
+    uint64_t journalLsn;  // Set by a successful Load
+
+    DriveSnapshot() : base(nullptr), header(nullptr), corrupt(false), journalLsn(0) {}
+
+    /**
+     * @brief  Writes the graph to path atomically and durably (temp file,
+     *         fsync, rename, fsync of the directory).
+     * @return false if any step failed, in which case the journal must be kept.
+     */
+    bool Save(UserGraph& graph, const string& path, uint64_t journalLsn) {
+        // Chunk bytes go after every other string and are written straight
+        // from the store, so offsets are relative to that tail until then
+        uint64_t chunkBytes = 0;
+        chunkSlot.assign(chunkStore.chunks.size(), 0);
+        for (uint32_t id = 0; id < chunkStore.chunks.size(); id++) {
+            const ChunkStore::Chunk& c = chunkStore.chunks[id];
+            if (c.refs == 0) continue;
+            SnapChunk rec = {};
+            memcpy(rec.hash, c.hash.bytes, 32);
+            rec.data = {chunkBytes, (uint32_t)c.data.size(), 0};
+            chunkBytes += c.data.size();
+            rec.rawSize = c.rawSize;
+            rec.codec = c.codec;
+            chunkSlot[id] = chunks.size();
+            chunks.push_back(rec);
+        }
 
-    void AddFriend(User* currentUser) {
-        cout << " Find Friend (Autocomplete):\n";
-        string prefix = Trim(InputString(" Enter prefix to search: "));
-        userTrie.AutoComplete(prefix);
+        graph.users.ForEach([&](User& u) {
+            SnapUser rec = {};
+            rec.id = u.id;
+            rec.name = Put(u.username);
+            rec.password = Put(u.password);
+            rec.securityQ = Put(u.securityQ);
+            rec.securityA = Put(u.securityA);
+            rec.folderCounter = u.folderCounter;
+            rec.trashCapacity = u.trash.Capacity();
+            rec.trashRetention = u.trash.Retention();
+            CollectFolders(u, rec);
+
+            NotificationNode* tail = u.notifications.tail;
+            if (tail) {
+                NotificationNode* cur = tail->next;
+                do {
+                    notes.push_back(Put(cur->message));
+                    rec.noteCount++;
+                    cur = cur->next;
+                } while (cur != tail->next);
+            }
+            users.push_back(rec);
 
-        string target = Trim(InputString(" Enter exact username to add: "));
+            graph.adj.ForEachNeighbor(u.id, [&](uint32_t j) {
+                if (j > u.id) edges.push_back({u.id, j});
+            });
+        });
 
-        int u1 = GetUserIndex(currentUser->GetName());
-        int u2 = GetUserIndex(target);
+        for (uint32_t id = 0; id < graph.users.NextID(); id++) {
+            if (!graph.users.Get(id)) retired.push_back(id);
+        }
 
-        if(u2 == -1 || u1 == u2) {
-            cout << " [ERROR] Invalid user.\n";
-            return;
+        for (SnapChunk& rec : chunks) rec.data.offset += heap.size();
+
+        SnapHeader h = {};
+        memcpy(h.magic, "GDSNAP\0\0", 8);
+        h.formatVersion = SNAPSHOT_FORMAT_VERSION;
+        h.byteOrder = SNAPSHOT_BYTE_ORDER;
+        h.userCount = users.size();
+        h.folderCount = folders.size();
+        h.fileCount = files.size();
+        h.versionCount = versions.size();
+        h.noteCount = notes.size();
+        h.edgeCount = edges.size();
+        h.userOffset = Align8(sizeof(SnapHeader));
+        h.folderOffset = Align8(h.userOffset + users.size() * sizeof(SnapUser));
+        h.fileOffset = Align8(h.folderOffset + folders.size() * sizeof(SnapFolder));
+        h.versionOffset = Align8(h.fileOffset + files.size() * sizeof(SnapFile));
+        h.noteOffset = Align8(h.versionOffset + versions.size() * sizeof(SnapVersion));
+        h.edgeOffset = Align8(h.noteOffset + notes.size() * sizeof(SnapStr));
+        h.chunkCount = chunks.size();
+        h.chunkRefCount = chunkRefs.size();
+        h.chunkOffset = Align8(h.edgeOffset + edges.size() * sizeof(SnapEdge));
+        h.chunkRefOffset = Align8(h.chunkOffset + chunks.size() * sizeof(SnapChunk));
+        h.recentCount = recents.size();
+        h.recentOffset = Align8(h.chunkRefOffset + chunkRefs.size() * sizeof(uint32_t));
+        h.retiredCount = retired.size();
+        h.retiredOffset = Align8(h.recentOffset + recents.size() * sizeof(SnapRecent));
+        h.heapOffset = Align8(h.retiredOffset + retired.size() * sizeof(uint32_t));
+        h.heapSize = heap.size() + chunkBytes;
+        h.fileSize = h.heapOffset + h.heapSize;
+        h.journalLsn = journalLsn;
+        h.userIDBound = graph.users.NextID();
+
+        // The temp file must be on disk before the rename publishes it, and the
+        // rename must be on disk before the caller empties the journal
+        string tmpPath = path + ".tmp";
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        if (!f) return false;
+        {
+            SnapWriter out = {f, 0, true};
+            out.Write(&h, sizeof(h));
+            WriteSection(out, users, h.userOffset);
+            WriteSection(out, folders, h.folderOffset);
+            WriteSection(out, files, h.fileOffset);
+            WriteSection(out, versions, h.versionOffset);
+            WriteSection(out, notes, h.noteOffset);
+            WriteSection(out, edges, h.edgeOffset);
+            WriteSection(out, chunks, h.chunkOffset);
+            WriteSection(out, chunkRefs, h.chunkRefOffset);
+            WriteSection(out, recents, h.recentOffset);
+            WriteSection(out, retired, h.retiredOffset);
+            out.PadTo(h.heapOffset);
+            out.Write(heap.data(), heap.size());
+            for (const ChunkStore::Chunk& c : chunkStore.chunks) {
+                if (c.refs > 0) out.Write(c.data.data(), c.data.size());
+            }
+            if (!CloseDurably(f) || !out.ok) {
+                remove(tmpPath.c_str());
+                return false;
+            }
+        }
+        if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+            remove(tmpPath.c_str());
+            return false;
         }
+        return SyncParentDir(path);
+    }
 
-        if(adj[u1][u2] == 1) {
-            cout << " [INFO] Already friends.\n";
-            return;
+    /**
+     * @brief  Replaces the (empty) graph with the snapshot stored at path.
+     * @return false if the file is missing, from another format version or corrupt.
+     */
+    bool Load(UserGraph& graph, const string& path) {
+        bool ok = LoadInto(graph, path);
+        versionNodes.clear();  // Files now hold the versions they use
+        versionDepth.clear();
+        if (!ok) {
+            Discard(graph);
+            return false;
         }
+        return true;
+    }
 
-        adj[u1][u2] = 1;
-        adj[u2][u1] = 1;
+private:
+    bool LoadInto(UserGraph& graph, const string& path) {
+        MappedFile map;
+        if (!map.Open(path) || map.Size() < sizeof(SnapHeader)) return false;
+        base = map.Data();
+        header = (const SnapHeader*)base;
+        const SnapHeader& h = *header;
+        if (memcmp(h.magic, "GDSNAP\0\0", 8) != 0 || h.byteOrder != SNAPSHOT_BYTE_ORDER) return false;
+        if (h.formatVersion != SNAPSHOT_FORMAT_VERSION) {
+            cerr << " [ERROR] Snapshot format v" << h.formatVersion << " is not supported (expected v"
+                 << SNAPSHOT_FORMAT_VERSION << ").\n";
+            return false;
+        }
+        if (h.fileSize != map.Size() || h.heapOffset > map.Size() || h.heapSize > map.Size() - h.heapOffset) return false;
+        journalLsn = h.journalLsn;  // The mapping is gone once this returns
+
+        const SnapUser* su = Section<SnapUser>(h.userOffset, h.userCount, map.Size());
+        const SnapFolder* sf = Section<SnapFolder>(h.folderOffset, h.folderCount, map.Size());
+        const SnapFile* sfile = Section<SnapFile>(h.fileOffset, h.fileCount, map.Size());
+        const SnapVersion* sv = Section<SnapVersion>(h.versionOffset, h.versionCount, map.Size());
+        const SnapStr* sn = Section<SnapStr>(h.noteOffset, h.noteCount, map.Size());
+        const SnapEdge* se = Section<SnapEdge>(h.edgeOffset, h.edgeCount, map.Size());
+        const SnapChunk* sc = Section<SnapChunk>(h.chunkOffset, h.chunkCount, map.Size());
+        const uint32_t* refs = Section<uint32_t>(h.chunkRefOffset, h.chunkRefCount, map.Size());
+        const SnapRecent* sr = Section<SnapRecent>(h.recentOffset, h.recentCount, map.Size());
+        const uint32_t* retiredIDs = Section<uint32_t>(h.retiredOffset, h.retiredCount, map.Size());
+        if (corrupt) return false;
+
+        // Child counts must add up before anything walks the sections
+        uint64_t folderTotal = 0, fileTotal = 0, noteTotal = 0, recentTotal = 0;
+        for (uint64_t i = 0; i < h.userCount; i++) { folderTotal += su[i].folderCount; noteTotal += su[i].noteCount; }
+        for (uint64_t i = 0; i < h.folderCount; i++) { fileTotal += sf[i].fileCount; recentTotal += sf[i].recentCount; }
+        uint64_t refTotal = 0;
+        for (uint64_t i = 0; i < h.versionCount; i++) refTotal += sv[i].isKeyframe ? sv[i].chunkCount : 0;
+        if (folderTotal != h.folderCount || fileTotal != h.fileCount || noteTotal != h.noteCount ||
+            refTotal != h.chunkRefCount || recentTotal != h.recentCount) return false;
+
+        // Chunks first; the versions below take their references
+        chunkIDs.resize(h.chunkCount);
+        for (uint64_t i = 0; i < h.chunkCount; i++) {
+            Sha256::Digest hash;
+            memcpy(hash.bytes, sc[i].hash, 32);
+            if (sc[i].codec >= CODEC_COUNT || sc[i].rawSize == 0) return false;
+            chunkIDs[i] = chunkStore.Insert(hash, Get(sc[i].data), sc[i].rawSize, (CodecID)sc[i].codec);
+        }
+        if (!LoadVersions(sv, h.versionCount, refs)) return false;
+
+        // Live and retired IDs must cover [0, userIDBound) exactly once, so the
+        // bound, and every array sized by user ID, is paid for by the file's size
+        size_t n = h.userCount;
+        if (n + h.retiredCount != h.userIDBound || h.userIDBound >= UserDirectory::NO_USER) return false;
+        for (uint64_t id = 0, live = 0, dead = 0; id < h.userIDBound; id++) {
+            if (live < n && su[live].id == id) live++;
+            else if (dead < h.retiredCount && retiredIDs[dead] == id) dead++;
+            else return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (!TrashPolicy::ValidLimits(su[i].trashCapacity, su[i].trashRetention)) return false;
+            User* u = new User();  // Owned here until the directory takes it below
+            u->Setup(Get(su[i].name), Get(su[i].password), Get(su[i].securityQ), Get(su[i].securityA));
+            u->folderCounter = su[i].folderCounter;
+            u->trash.Reset(su[i].trashCapacity, su[i].trashRetention, time(nullptr));
+
+            vector<Folder*> loaded;  // In ID order, as written
+            for (uint32_t k = 0; k < su[i].folderCount; k++, sf++) {
+                // Fill the folder in place so its tables are never copied
+                Folder* folder = new Folder();
+                folder->SetValues(Get(sf->name), sf->id, u->username);
+                folder->fileIDCounter = sf->fileIDCounter;
+                loaded.push_back(folder);
+                uint32_t live = 0;
+                for (uint32_t j = 0; j < sf->fileCount; j++) {
+                    if (sfile[j].list == SNAP_LIVE) live++;
+                }
+                folder->files = HashTableFiles(max(INITIAL_HASH_SIZE, (int)(live / 0.7) + 1));
+
+                for (uint32_t j = 0; j < sf->fileCount; j++, sfile++) {
+                    File f = LoadFile(*sfile);
+                    switch (sfile->list) {
+                        case SNAP_LIVE:
+                            folder->UpdateStarred(f.GetID(), f.GetPriority());  // Starred = live files of priority 8+
+                            folder->files.Insert(move(f));
+                            break;
+                        case SNAP_TRASH: folder->deletedFiles.Push(move(f), sfile->deletedAt, u->trash.Capacity()); break;
+                        default: corrupt = true;
+                    }
+                }
+                folder->SetTrashPolicy(&u->trash);
+                for (uint32_t j = sf->recentCount; j-- > 0;) {  // Oldest first, so the newest ends in front
+                    folder->recentFiles.Touch(sr[j].fileID, sr[j].accessedAt);
+                }
+                sr += sf->recentCount;
+            }
+            if (!u->myFolders.BulkLoad(loaded)) {  // Out of order or duplicate IDs
+                for (Folder* folder : loaded) delete folder;
+                corrupt = true;
+            }
+            for (uint32_t k = 0; k < su[i].noteCount; k++, sn++) {
+                u->notifications.AddNotification(Get(*sn));
+            }
 
-        cout << " [SUCCESS] You are now friends with " << users[u2]->GetName() << "!\n";
-}
+            if (!graph.users.Restore(u, su[i].id)) {
+                delete u;
+                return false;
+            }
+            graph.userTrie.Insert(u->username);
+        }
+        graph.users.ReserveIDs(h.userIDBound);
 
-    // BFS Algorithm to find "Friend of a Friend"
-    void RecommendFriends(User* currentUser) {
-        int startNode = GetUserIndex(currentUser->GetName());
-        if(startNode == -1) return;
+        vector<pair<uint32_t, uint32_t>> friendships;
+        friendships.reserve(h.edgeCount);
+        for (uint64_t i = 0; i < h.edgeCount; i++) {
+            if (!graph.users.Get(se[i].a) || !graph.users.Get(se[i].b)) { corrupt = true; break; }
+            friendships.push_back({se[i].a, se[i].b});
+        }
+        if (!graph.adj.Build(graph.users.Bound(), friendships)) corrupt = true;
+        graph.components.Rebuild(graph.adj);
+        graph.users.ForEach([&graph](User& u) { graph.userTrie.SetScore(u.username, graph.FriendCount(u.id)); });
+        return !corrupt;
+    }
+};
 
-        bool visited[100] = {false};
-        queue<int> q;
-        
-        visited[startNode] = true;
-        q.push(startNode);
-        
-        cout << "\n --- FRIEND RECOMMENDATIONS (BFS) ---\n";
-        bool found = false;
-
-        while(!q.empty()) {
-            int u = q.front();
-            q.pop();
-
-            for(size_t v=0; v<users.size(); v++) {
-                if(adj[u][v] == 1 && !visited[v]) {
-                    visited[v] = true;
-                    q.push(v);
-                    
-                    // If v is not directly connected to startNode, suggest it
-                    if(adj[startNode][v] == 0 && v != startNode) {
-                        cout << " Suggestion: " << users[v]->GetName() << " (Friend of " << users[u]->GetName() << ")\n";
-                        found = true;
-                    }
+/**
+ * @class JournalReplayer
+ * @brief Re-applies journal records to the graph during crash recovery.
+ */
+class JournalReplayer {
+private:
+    // An upload whose chunks have been replayed but whose commit has not been seen yet
+    struct PendingUpload {
+        string name, type;
+        int prio;
+        ChunkList content;
+    };
+    map<string, PendingUpload> uploads;  // Keyed by user/folder/file ID
+
+    static Folder* FindFolder(UserGraph& graph, const string& user, int folderID) {
+        User* u = graph.FindUser(user);
+        return u ? u->GetFolder(folderID) : nullptr;
+    }
+
+    static string UploadKey(const string& user, int folderID, int fileID) {
+        return user + "/" + to_string(folderID) + "/" + to_string(fileID);
+    }
+
+public:
+    // Uploads still pending when replay ends never committed; dropping them releases their chunks
+    int DiscardPending() {
+        int n = uploads.size();
+        uploads.clear();
+        return n;
+    }
+
+    // Returns false if the record is malformed or no longer applies
+    bool Apply(UserGraph& graph, const string& payload) {
+        JournalReader r(payload);
+        string user, other, name, type, content, q, a;
+        int folderID, fileID, prio, codec, rawSize;
+
+        switch (r.Op()) {
+            case JOP_REGISTER:
+                return r.Str(user) && r.Str(other) && r.Str(q) && r.Str(a) &&
+                       graph.RegisterUser(user, other, q, a);
+            case JOP_RESET_PASSWORD:
+                return r.Str(user) && r.Str(other) && graph.ResetPassword(user, other);
+            case JOP_CREATE_FOLDER: {
+                if (!r.Str(user) || !r.Int(folderID) || !r.Str(name)) return false;
+                User* u = graph.FindUser(user);
+                return u && u->CreateFolder(name) == folderID;
+            }
+            case JOP_CREATE_FILE: {
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileID) || !r.Str(name) ||
+                    !r.Str(type) || !r.Int(prio) || !r.Str(content)) return false;
+                Folder* f = FindFolder(graph, user, folderID);
+                return f && f->CreateFile(name, type, content, prio) == fileID;
+            }
+            case JOP_DELETE_FILE: {
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileID)) return false;
+                int64_t deletedAt;
+                if (!r.Int(deletedAt)) deletedAt = time(nullptr);  // Written before deletion times were logged
+                Folder* f = FindFolder(graph, user, folderID);
+                return f && f->DeleteFile(fileID, deletedAt);
+            }
+            case JOP_RECOVER_FILE: {
+                if (!r.Str(user) || !r.Int(folderID)) return false;
+                Folder* f = FindFolder(graph, user, folderID);
+                return f && f->RestoreFromTrash();
+            }
+            case JOP_ADD_FRIEND: {
+                if (!r.Str(user) || !r.Str(other)) return false;
+                User* u = graph.FindUser(user);
+                return u && graph.AddFriend(u, other) == UserGraph::FRIEND_ADDED;
+            }
+            case JOP_EDIT_FILE: {
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileID) || !r.Str(content)) return false;
+                Folder* f = FindFolder(graph, user, folderID);
+                return f && f->EditFile(fileID, content);
+            }
+            case JOP_SHARE_FILE: {
+                if (!r.Str(user) || !r.Str(other) || !r.Int(folderID) || !r.Int(fileID)) return false;
+                User* u = graph.FindUser(user);
+                return u && graph.ShareFile(u, other, folderID, fileID);
+            }
+            case JOP_SET_PRIORITY: {
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileID) || !r.Int(prio)) return false;
+                Folder* f = FindFolder(graph, user, folderID);
+                return f && f->SetFilePriority(fileID, prio);
+            }
+            case JOP_DELETE_USER:
+                return r.Str(user) && graph.DeleteUser(user);
+            case JOP_SHARE_BATCH: {
+                int fileCount, receiverCount;
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileCount) || fileCount < 0) return false;
+                vector<int> fileIDs(fileCount);
+                for (int& id : fileIDs) {
+                    if (!r.Int(id)) return false;
+                }
+                if (!r.Int(receiverCount) || receiverCount < 0) return false;
+                vector<string> receivers(receiverCount);
+                for (string& name : receivers) {
+                    if (!r.Str(name)) return false;
                 }
+                User* u = graph.FindUser(user);
+                return u && graph.ShareFiles(u, folderID, fileIDs, receivers) > 0;
+            }
+            case JOP_DELETE_FOLDER: {
+                if (!r.Str(user) || !r.Int(folderID)) return false;
+                User* u = graph.FindUser(user);
+                return u && u->DeleteFolder(folderID);
+            }
+            case JOP_TRASH_LIMITS: {
+                int capacity;
+                int64_t retention;
+                if (!r.Str(user) || !r.Int(capacity) || !r.Int(retention)) return false;
+                User* u = graph.FindUser(user);
+                return u && u->SetTrashLimits(capacity, retention);
             }
-        }
-        if(!found) cout << " No suggestions available.\n";
-    }
-
-    // DFS Algorithm - Depth First Search
-    void DFSHelper(int node, bool visited[], vector<int>& component) {
-        visited[node] = true;
-        component.push_back(node);
-        
-        for (size_t i = 0; i < users.size(); i++) {
-            if (adj[node][i] == 1 && !visited[i]) {
-                DFSHelper(i, visited, component);
+            case JOP_UPLOAD_BEGIN: {
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileID) || !r.Str(name) ||
+                    !r.Str(type) || !r.Int(prio)) return false;
+                PendingUpload& up = uploads[UploadKey(user, folderID, fileID)];
+                up.name = name;
+                up.type = type;
+                up.prio = prio;
+                up.content = ChunkList();  // An earlier upload to this ID was abandoned
+                return true;
             }
-        }
-    }
-
-    void FindConnectedComponents(User* currentUser) {
-        int startNode = GetUserIndex(currentUser->GetName());
-        if (startNode == -1) return;
-        
-        bool visited[100] = {false};
-        vector<int> component;
-        
-        DFSHelper(startNode, visited, component);
-        
-        cout << "\n --- CONNECTED USERS (DFS - Depth First Search) ---\n";
-        cout << " Your connected network includes:\n";
-        bool found = false;
-        for (int idx : component) {
-            if (idx != startNode) {
-                cout << " - " << users[idx]->GetName() << endl;
-                found = true;
+            case JOP_UPLOAD_CHUNK: {
+                string hash;
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileID) || !r.Str(hash) ||
+                    !r.Int(codec) || !r.Int(rawSize) || !r.Str(content)) return false;
+                auto it = uploads.find(UploadKey(user, folderID, fileID));
+                if (it == uploads.end() || hash.size() != 32 || codec < 0 || codec >= CODEC_COUNT) return false;
+                Sha256::Digest digest;
+                memcpy(digest.bytes, hash.data(), 32);
+                uint32_t chunk;
+                if (!chunkStore.PutEncoded(digest, content, rawSize, (CodecID)codec, chunk)) return false;
+                it->second.content.Append(chunk);
+                return true;
+            }
+            case JOP_UPLOAD_COMMIT: {
+                if (!r.Str(user) || !r.Int(folderID) || !r.Int(fileID) || !r.Int(codec)) return false;
+                auto it = uploads.find(UploadKey(user, folderID, fileID));
+                Folder* f = FindFolder(graph, user, folderID);
+                if (it == uploads.end() || !f || codec < 0 || codec >= CODEC_COUNT) return false;
+                PendingUpload& up = it->second;
+                bool ok = f->AddStreamedFile(up.name, up.type, move(up.content), (CodecID)codec, up.prio) == fileID;
+                uploads.erase(it);
+                return ok;
             }
         }
-        if (!found) cout << " No connected users found.\n";
+        return false;
     }
+};
 
-    void FindAllPathsHelper(int start, int end, bool visited[], vector<int>& path, vector<vector<int>>& allPaths) {
-        visited[start] = true;
-        path.push_back(start);
-        
-        if (start == end) {
-            allPaths.push_back(path);
+/**
+ * @brief  Rebuilds the drive from its snapshot plus the journal written since,
+ *         then opens the journal for new mutations.
+ * @return false if a snapshot exists but cannot be read. The caller must not
+ *         start, or its next save would replace the user's only copy.
+ */
+bool RecoverDrive(UserGraph& network, const string& path) {
+    auto start = chrono::steady_clock::now();
+    uint64_t snapshotLsn = 0;
+    ifstream probe(path);
+    if (probe) {
+        probe.close();
+        DriveSnapshot snapshot;
+        if (snapshot.Load(network, path)) {
+            snapshotLsn = snapshot.journalLsn;
         } else {
-            for (size_t i = 0; i < users.size(); i++) {
-                if (adj[start][i] == 1 && !visited[i]) {
-                    FindAllPathsHelper(i, end, visited, path, allPaths);
-                }
-            }
+            cerr << " [ERROR] Snapshot '" << path << "' is unreadable; refusing to start.\n"
+                 << "         Repair it or move it aside (the journal '" << path << ".wal' belongs with it).\n";
+            return false;
         }
-        
-        path.pop_back();
-        visited[start] = false;
     }
 
-    void FindPathBetweenUsers(User* currentUser) {
-        string targetName = InputString(" Enter target username: ");
-        int startNode = GetUserIndex(currentUser->GetName());
-        int endNode = GetUserIndex(targetName);
-        
-        if (startNode == -1 || endNode == -1) {
-            cout << " [ERROR] Invalid user(s).\n";
-            return;
-        }
-        
-        if (startNode == endNode) {
-            cout << " [INFO] Same user selected.\n";
-            return;
-        }
-        
-        bool visited[100] = {false};
-        vector<int> path;
-        vector<vector<int>> allPaths;
-        
-        FindAllPathsHelper(startNode, endNode, visited, path, allPaths);
-        
-        cout << "\n --- PATHS BETWEEN USERS (DFS) ---\n";
-        if (allPaths.empty()) {
-            cout << " No path found between " << currentUser->GetName() << " and " << targetName << ".\n";
-        } else {
-            cout << " Found " << allPaths.size() << " path(s):\n";
-            for (size_t i = 0; i < allPaths.size(); i++) {
-                cout << " Path " << (i+1) << ": ";
-                for (size_t j = 0; j < allPaths[i].size(); j++) {
-                    cout << users[allPaths[i][j]]->GetName();
-                    if (j < allPaths[i].size() - 1) cout << " -> ";
-                }
-                cout << endl;
-            }
-        }
+    // The global journal is still closed here, so replayed operations are not re-logged
+    // Records are applied as they are read, so a journal of large uploads is never held in memory
+    string walPath = path + ".wal";
+    JournalReplayer replayer;
+    uint64_t lastLsn;
+    size_t replayed = 0;
+    int failed = 0;
+    long validBytes = Journal::Scan(walPath, snapshotLsn, [&](const string& rec) {
+        replayed++;
+        if (!replayer.Apply(network, rec)) failed++;
+    }, lastLsn);
+    int abandoned = replayer.DiscardPending();
+
+    chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+    if (snapshotLsn > 0 || replayed > 0) {
+        cout << " [INFO] Restored drive from '" << path << "' (+" << replayed
+             << " journal records) in " << fixed << setprecision(2) << ms.count() << " ms.\n" << defaultfloat;
     }
+    if (failed) cerr << " [WARN] " << failed << " journal records could not be re-applied.\n";
+    if (abandoned) cerr << " [WARN] " << abandoned << " interrupted uploads were dropped.\n";
 
-    // --- FILE SHARING LOGIC ---
+    if (!journal.Open(walPath, validBytes, lastLsn)) {
+        cerr << " [ERROR] Cannot open journal '" << walPath << "'; changes will not survive a crash.\n";
+    }
+    return true;
+}
 
-    void ShareFile(User* sender) {
-        string targetName = InputString(" Enter username to share with: ");
-        int receiverIdx = GetUserIndex(targetName);
-        
-        if(receiverIdx == -1) { cout << " User not found.\n"; return; }
-        
-        User* receiver = users[receiverIdx];
-        
-        // Select File
-        sender->GetFolderTree()->DisplayAll();
-        int folderID = InputInt(" Select source Folder ID: ");
-        Folder* srcFolder = sender->GetFolder(folderID);
-        
-        if(!srcFolder) { cout << " Invalid folder.\n"; return; }
-        
-        // We need a way to list files - for now, just ask for file ID
-        // In a real implementation, we'd have a method to list files
-        cout << "\n Note: You'll need to know the File ID from the folder.\n";
-        int fileID = InputInt(" Enter File ID to share: ");
-        
-        File* file = srcFolder->GetFileById(fileID);
-        if(!file) { cout << " File not found.\n"; return; }
-        
-        // Create or find "Shared with Me" folder
-        // Use a special high ID (9999) for shared folder to avoid conflicts
-        Folder* sharedFolder = receiver->GetFolder(9999);
-        if (!sharedFolder) {
-            // Create shared folder
-            Folder newShared;
-            newShared.SetValues("Shared with Me", 9999, receiver->GetName());
-            receiver->GetFolderTree()->AddFolder(newShared);
-            sharedFolder = receiver->GetFolder(9999);
-        }
-        
-        // Actually copy the file
-        File sharedFile = *file;  // Copy file
-        // Get a new ID from the shared folder's counter
-        int newFileID = sharedFolder->GetFileIDCounter();
-        sharedFile.SetID(newFileID);
-        sharedFolder->InsertSharedFile(sharedFile);
-        
-        receiver->AddNotification("User " + sender->GetName() + " shared file: " + file->GetName());
-        
-        cout << " [SUCCESS] File '" << file->GetName() << "' shared and copied to " << receiver->GetName() << "'s 'Shared with Me' folder.\n";
-        sysLog.Log("Share", sender->GetName() + " shared " + file->GetName() + " with " + targetName);
+/**
+ * @brief Writes a snapshot and then empties the journal it supersedes.
+ */
+void SaveSnapshot(UserGraph& network, const string& path) {
+    journal.Sync();  // Even after a journal failure: the snapshot covers what it dropped
+    DriveSnapshot snapshot;
+    if (!snapshot.Save(network, path, journal.LastLsn())) {
+        cerr << " [ERROR] Could not write snapshot '" << path << "'.\n";
+    } else if (!journal.Checkpoint()) {
+        // Harmless for recovery (replay skips records the snapshot covers), but worth knowing
+        cerr << " [WARN] Drive saved to '" << path << "', but its journal could not be emptied.\n";
+    } else {
+        cout << " [INFO] Drive saved to '" << path << "'.\n";
     }
-};
+}
 
 class GoogleDriveSystem {
 private:
     UserGraph network;
     User* currentUser;
+    string snapshotPath;
+    bool recovered;
 
 public:
-    GoogleDriveSystem() : currentUser(nullptr) {}
+    GoogleDriveSystem(const string& snapPath = SNAPSHOT_FILE) : currentUser(nullptr), snapshotPath(snapPath) {
+        recovered = RecoverDrive(network, snapshotPath);
+    }
+
+    bool Recovered() const { return recovered; }
 
     void UserDashboard() {
         while (currentUser) {
             ClearScreen();
             PrintHeader("DASHBOARD: " + currentUser->GetName());
+            size_t expired = currentUser->ExpireTrash(time(nullptr));
+            if (expired) cout << " [INFO] " << expired << " file(s) expired from the trash.\n";
             cout << " 1. Create New Folder\n";
             cout << " 2. Open Folder\n";
             cout << " 3. Notifications\n";
             cout << " 4. Add Friend (Search)\n";
-            cout << " 5. Friend Recommendations (BFS)\n";
-            cout << " 6. Find Connected Users (DFS)\n";
-            cout << " 7. Find Path Between Users (DFS)\n";
+            cout << " 5. Friend Recommendations (Mutual Friends)\n";
+            cout << " 6. Find Connected Users (Union-Find)\n";
+            cout << " 7. Find Path Between Users (BFS)\n";
             cout << " 8. Share File\n";
             cout << " 9. System Logs (Admin)\n";
-            cout << " 10. Logout\n";
+            cout << " 10. Trash Settings\n";
+            cout << " 11. Recent Files (All Folders)\n";
+            cout << " 12. Delete Folder\n";
+            cout << " 13. Delete Account\n";
+            cout << " 14. Network Analytics\n";
+            cout << " 15. Logout\n";
             PrintLine();
 
-            int choice = InputInt(" Select Action: ", 1, 10);
+            int choice = InputInt(" Select Action: ", 1, 15);
 
             switch (choice) {
                 case 1: currentUser->CreateFolder(); break;
@@ -1908,13 +7646,24 @@ public:
                 case 6: network.FindConnectedComponents(currentUser); break;
                 case 7: network.FindPathBetweenUsers(currentUser); break;
                 case 8: network.ShareFile(currentUser); break;
-                case 9: sysLog.DisplayLogs(); break;
-                case 10: 
+                case 9:
+                    sysLog.DisplayLogs();
+                    chunkStore.DisplayStats();
+                    break;
+                case 10: currentUser->SetTrashLimits(); break;
+                case 11: currentUser->ShowRecentFiles(); break;
+                case 12: currentUser->DeleteFolder(); break;
+                case 13:
+                    if (network.DeleteUser(currentUser)) currentUser = nullptr;
+                    break;
+                case 14: network.ShowAnalytics(currentUser); break;
+                case 15: 
                     currentUser = nullptr; 
                     cout << " Logging out...\n";
                     return;
             }
-            if(choice != 10) {
+            CommitJournal();
+            if(choice != 15) {
                 cout << "\n (Press Enter to continue...)";
                 cin.get();
             }
@@ -1958,15 +7707,17 @@ public:
                 case 4:
                     PrintHeader("CREDITS");
                     cout << " Developed for: Data Structures and Alogorithm Final Semester Project\n";
-                    cout << " Features: AVL Trees, Hash Tables, Graphs, Tries, Heaps.\n";
+                    cout << " Features: B+ Trees, AVL Trees, Hash Tables, Graphs, Tries, Heaps.\n";
                     cout << " Submitted by:\n -M.Zawar Fahim \n -Hamza Sami \n -M.Asad Akmal";
                     cout << "\n Press Enter to return.";
                     cin.get();
                     break;
                 case 5:
+                    SaveSnapshot(network, snapshotPath);
                     cout << " Shutting down system. Goodbye!\n";
                     exit(0);
             }
+            CommitJournal();
             if (choice != 1) { // Login handles its own pause
                 cout << "\n (Press Enter to continue...)";
                 cin.get();
@@ -1975,9 +7726,949 @@ public:
     }
 };
 
-int main(){
+/**
+ * @class LatencyRecorder
+ * @brief Collects per-command latency samples for scripted runs.
+ */
+class LatencyRecorder {
+private:
+    struct CommandStats {
+        vector<long long> samplesNs;
+        int failures = 0;
+    };
+    map<string, CommandStats> stats;
+
+    static double Percentile(const vector<long long>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t idx = (size_t)ceil(p / 100.0 * sorted.size());
+        if (idx > 0) idx--;
+        return sorted[min(idx, sorted.size() - 1)] / 1000.0;
+    }
+
+public:
+    void Record(const string& command, long long ns, bool ok) {
+        CommandStats& cs = stats[command];
+        cs.samplesNs.push_back(ns);
+        if (!ok) cs.failures++;
+    }
+
+    void Report(double wallSeconds) {
+        PrintHeader("SCRIPT THROUGHPUT REPORT");
+        cout << " (latencies in microseconds)\n";
+        cout << " " << left << setw(10) << "COMMAND" << right
+             << setw(9) << "OPS" << setw(7) << "FAIL"
+             << setw(12) << "OPS/SEC"
+             << setw(12) << "P50" << setw(12) << "P90"
+             << setw(12) << "P99" << setw(13) << "MAX" << "\n";
+        PrintLine();
+        long long totalOps = 0;
+        for (auto& entry : stats) {
+            vector<long long>& v = entry.second.samplesNs;
+            sort(v.begin(), v.end());
+            long long busyNs = 0;
+            for (long long ns : v) busyNs += ns;
+            double opsPerSec = busyNs > 0 ? v.size() * 1e9 / busyNs : 0;
+            totalOps += v.size();
+
+            cout << " " << left << setw(10) << entry.first << right
+                 << setw(9) << v.size() << setw(7) << entry.second.failures
+                 << setw(12) << fixed << setprecision(1) << opsPerSec
+                 << setprecision(2)
+                 << setw(12) << Percentile(v, 50) << setw(12) << Percentile(v, 90)
+                 << setw(12) << Percentile(v, 99) << setw(13) << Percentile(v, 100) << "\n";
+        }
+        PrintLine();
+        cout << " Total: " << totalOps << " ops in " << setprecision(3) << wallSeconds << " s";
+        if (wallSeconds > 0) cout << " (" << setprecision(0) << totalOps / wallSeconds << " ops/sec overall)";
+        cout << "\n" << defaultfloat;
+    }
+};
+
+/**
+ * @class ScriptRunner
+ * @brief Headless command interpreter that drives the engine without menus.
+ *
+ * One command per line; '#' starts a comment. Arguments are separated by
+ * whitespace, except file content which takes the rest of the line.
+ *   register <user> <pass> [question] [answer]
+ *   login <user> <pass>          logout
+ *   unregister                   (deletes the logged-in account)
+ *   mkdir <name>                 (folder IDs start at 1 for each user)
+ *   rmdir <folderID>
+ *   mkfile <folderID> <name> <type> <prio> <content...>
+ *   edit <folderID> <fileID> <content...>
+ *   version <folderID> <fileID> <versionNumber>
+ *   search <folderID> <fileID>   delete <folderID> <fileID>
+ *   recover <folderID>           friend <user>
+ *   suggest <prefix> [k]         (usernames, most friends first)
+ *   recommend [k]                (friends of friends, most mutual friends first)
+ *   path <user> [k] [maxHops]    (k shortest friendship paths to user)
+ *   network                      (size of your connected network)
+ *   analytics [user]             (degree, component and BFS statistics job)
+ *   share <user> <folderID> <fileID>
+ *   sharemany <folderID> <fileID,fileID,...> <user,user,...|@friends>
+ *   sort <folderID> <bubble|insertion|selection|merge|heap|counting|quick|radix>
+ *   upload <folderID> <path> <name> <type> <prio>
+ *   download <folderID> <fileID> <path>
+ */
+class ScriptRunner {
+private:
+    UserGraph& network;
+    User* currentUser;
+    LatencyRecorder recorder;
+    int lineNumber;
+
+    void Warn(const string& msg) {
+        cerr << " [SCRIPT] line " << lineNumber << ": " << msg << "\n";
+    }
+
+    Folder* CurrentFolder(int folderID) {
+        return currentUser ? currentUser->GetFolder(folderID) : nullptr;
+    }
+
+    static int SortOption(const string& algo) {
+        static const string names[] = {"bubble", "insertion", "selection", "merge",
+                                       "heap", "counting", "quick", "radix"};
+        for (int i = 0; i < 8; i++) {
+            if (names[i] == algo) return 11 + i;
+        }
+        return -1;
+    }
+
+    // Returns false when the command fails or its arguments are malformed
+    bool Execute(const string& cmd, istringstream& args) {
+        if (cmd == "register") {
+            string u, p, sq = "-", sa = "-";
+            if (!(args >> u >> p)) return false;
+            args >> sq >> sa;
+            return network.RegisterUser(u, p, sq, sa);
+        }
+        if (cmd == "login") {
+            string u, p;
+            if (!(args >> u >> p)) return false;
+            currentUser = network.Login(u, p);
+            if (currentUser) currentUser->ExpireTrash(time(nullptr));
+            return currentUser != nullptr;
+        }
+        if (cmd == "logout") {
+            currentUser = nullptr;
+            return true;
+        }
+        if (cmd == "unregister") {
+            if (!currentUser) return false;
+            string name = currentUser->GetName();
+            currentUser = nullptr;
+            return network.DeleteUser(name);
+        }
+        if (cmd == "mkdir") {
+            string fname;
+            if (!currentUser || !(args >> fname)) return false;
+            currentUser->CreateFolder(fname);
+            return true;
+        }
+        if (cmd == "rmdir") {
+            int folderID;
+            return currentUser && (args >> folderID) && currentUser->DeleteFolder(folderID);
+        }
+        if (cmd == "suggest") {
+            string prefix;
+            size_t k = AUTOCOMPLETE_LIMIT;
+            if (!(args >> prefix)) return false;
+            args >> k;
+            return !network.Suggest(prefix, k).empty();
+        }
+        if (cmd == "recommend") {
+            size_t k = RECOMMEND_LIMIT;
+            if (!currentUser) return false;
+            args >> k;
+            network.RecommendFriends(currentUser->GetName(), k);
+            return true;
+        }
+        if (cmd == "network") {
+            return currentUser && network.NetworkSize(currentUser->GetName()) > 1;
+        }
+        if (cmd == "analytics") {
+            string source;
+            if (!(args >> source) && currentUser) source = currentUser->GetName();
+            return network.RunAnalytics(source).users > 0;
+        }
+        if (cmd == "path") {
+            string target;
+            size_t k = 1;
+            uint32_t maxHops = PATH_MAX_HOPS;
+            if (!currentUser || !(args >> target)) return false;
+            args >> k >> maxHops;
+            return !network.FindPaths(currentUser->GetName(), target, k, maxHops).empty();
+        }
+        if (cmd == "mkfile") {
+            int folderID, prio;
+            string fname, type, content;
+            if (!(args >> folderID >> fname >> type >> prio)) return false;
+            getline(args >> ws, content);
+            Folder* folder = CurrentFolder(folderID);
+            if (!folder || prio < 1 || prio > 10) return false;
+            folder->CreateFile(fname, type, content, prio);
+            return true;
+        }
+        if (cmd == "edit") {
+            int folderID, fileID;
+            string content;
+            if (!(args >> folderID >> fileID)) return false;
+            getline(args >> ws, content);
+            Folder* folder = CurrentFolder(folderID);
+            return folder && folder->EditFile(fileID, content);
+        }
+        if (cmd == "version") {
+            int folderID, fileID, ver;
+            if (!(args >> folderID >> fileID >> ver)) return false;
+            Folder* folder = CurrentFolder(folderID);
+            File* f = folder ? folder->GetFileById(fileID) : nullptr;
+            if (!f || ver < 1 || ver > f->GetVersionCount()) return false;
+            FileReader reader = f->OpenVersion(ver);
+            string piece;
+            while (reader.Next(piece)) {}
+            return true;
+        }
+        if (cmd == "search" || cmd == "delete") {
+            int folderID, fileID;
+            if (!(args >> folderID >> fileID)) return false;
+            Folder* folder = CurrentFolder(folderID);
+            if (!folder) return false;
+            return cmd == "search" ? folder->SearchFile(fileID) != nullptr
+                                   : folder->DeleteFile(fileID);
+        }
+        if (cmd == "recover") {
+            int folderID;
+            if (!(args >> folderID)) return false;
+            Folder* folder = CurrentFolder(folderID);
+            return folder && folder->RestoreFromTrash() != nullptr;
+        }
+        if (cmd == "trash") {
+            int capacity;
+            int64_t retention;
+            if (!currentUser || !(args >> capacity >> retention)) return false;
+            return currentUser->SetTrashLimits(capacity, retention);
+        }
+        if (cmd == "list") {
+            int folderID, page;
+            size_t pageSize = FILE_PAGE_SIZE;
+            string key, order = "asc";
+            if (!(args >> folderID >> key >> page) || page < 0) return false;
+            args >> pageSize >> order;
+            Folder* folder = CurrentFolder(folderID);
+            int k = key == "name" ? SORT_BY_NAME : key == "size" ? SORT_BY_SIZE : key == "prio" ? SORT_BY_PRIORITY : -1;
+            if (!folder || k == -1 || pageSize == 0) return false;
+            size_t seen = 0;
+            folder->PageFiles((FileSortKey)k, order == "desc", page, pageSize, [&seen](const File*) { seen++; });
+            return seen > 0;
+        }
+        if (cmd == "prio") {
+            int folderID, fileID, prio;
+            if (!(args >> folderID >> fileID >> prio)) return false;
+            Folder* folder = CurrentFolder(folderID);
+            return folder && folder->SetFilePriority(fileID, prio);
+        }
+        if (cmd == "starred") {
+            int folderID, k = STARRED_DISPLAY_LIMIT;
+            if (!(args >> folderID)) return false;
+            args >> k;
+            Folder* folder = CurrentFolder(folderID);
+            if (!folder) return false;
+            int seen = 0;
+            folder->ForEachStarred(k, [&seen](const File&) { seen++; });
+            return seen > 0;
+        }
+        if (cmd == "recent") {
+            int limit = MAX_RECENT_FILES;
+            if (!currentUser) return false;
+            args >> limit;
+            return !currentUser->RecentAcrossFolders(limit).empty();
+        }
+        if (cmd == "purge") {
+            if (!currentUser) return false;
+            currentUser->ExpireTrash(time(nullptr));
+            return true;
+        }
+        if (cmd == "friend") {
+            string target;
+            if (!currentUser || !(args >> target)) return false;
+            return network.AddFriend(currentUser, target) == UserGraph::FRIEND_ADDED;
+        }
+        if (cmd == "share") {
+            string target;
+            int folderID, fileID;
+            if (!currentUser || !(args >> target >> folderID >> fileID)) return false;
+            return network.ShareFile(currentUser, target, folderID, fileID);
+        }
+        if (cmd == "sharemany") {
+            int folderID;
+            string idList, userList;
+            if (!currentUser || !(args >> folderID >> idList >> userList)) return false;
+            vector<int> fileIDs;
+            vector<string> targets;
+            stringstream ids(idList), names(userList);
+            for (string id; getline(ids, id, ',');) fileIDs.push_back(atoi(id.c_str()));
+            for (string name; getline(names, name, ',');) targets.push_back(name);
+            if (userList == "@friends") return network.ShareWithFriends(currentUser, folderID, fileIDs) > 0;
+            return network.ShareFiles(currentUser, folderID, fileIDs, targets) > 0;
+        }
+        if (cmd == "upload") {
+            int folderID, prio;
+            string path, fname, type;
+            if (!(args >> folderID >> path >> fname >> type >> prio)) return false;
+            Folder* folder = CurrentFolder(folderID);
+            if (!folder || prio < 1 || prio > 10) return false;
+            return folder->UploadFile(path, fname, type, prio) != -1;
+        }
+        if (cmd == "download") {
+            int folderID, fileID;
+            string path;
+            if (!(args >> folderID >> fileID >> path)) return false;
+            Folder* folder = CurrentFolder(folderID);
+            return folder && folder->DownloadFile(fileID, path);
+        }
+        if (cmd == "sort") {
+            int folderID;
+            string algo;
+            if (!(args >> folderID >> algo)) return false;
+            Folder* folder = CurrentFolder(folderID);
+            int option = SortOption(algo);
+            if (!folder || option == -1) return false;
+            folder->RunSort(option, false);
+            return true;
+        }
+        return false;
+    }
+
+    static bool IsKnownCommand(const string& cmd) {
+        static const string known[] = {"register", "unregister", "login", "logout", "mkdir", "rmdir", "mkfile",
+                                       "edit", "version", "search", "delete", "recover", "trash", "purge", "recent",
+                                       "prio", "starred", "list", "friend", "suggest", "recommend", "path", "network",
+                                       "analytics", "share", "sharemany", "sort", "upload", "download"};
+        for (const string& k : known) {
+            if (k == cmd) return true;
+        }
+        return false;
+    }
+
+public:
+    ScriptRunner(UserGraph& g) : network(g), currentUser(nullptr), lineNumber(0) {}
+
+    void Run(istream& in) {
+        auto wallStart = chrono::steady_clock::now();
+        string line;
+        while (getline(in, line)) {
+            lineNumber++;
+            line = Trim(line);
+            if (line.empty() || line[0] == '#') continue;
+
+            istringstream args(line);
+            string cmd;
+            args >> cmd;
+            if (!IsKnownCommand(cmd)) {
+                Warn("unknown command '" + cmd + "'");
+                continue;
+            }
+
+            auto start = chrono::steady_clock::now();
+            bool ok = Execute(cmd, args);
+            auto end = chrono::steady_clock::now();
+            recorder.Record(cmd, chrono::duration_cast<chrono::nanoseconds>(end - start).count(), ok);
+        }
+        CommitJournal();  // Group commit: the whole run shares as few fsyncs as possible
+        chrono::duration<double> wall = chrono::steady_clock::now() - wallStart;
+        recorder.Report(wall.count());
+        chunkStore.DisplayStats();
+        if (journal.IsOpen()) journal.DisplayStats();
+    }
+};
+
+#ifdef DRIVE_BENCH
+/*
+ * Allocation counters for --bench, compiled only into bench builds
+ * (-DDRIVE_BENCH). Every global new then bumps two shared counters, which
+ * would put all threads of a normal build on one cache line.
+ */
+struct AllocCounter {
+    static atomic<uint64_t> bytes;
+    static atomic<uint64_t> count;
+};
+atomic<uint64_t> AllocCounter::bytes(0);
+atomic<uint64_t> AllocCounter::count(0);
+
+void* operator new(size_t n) {
+    AllocCounter::bytes.fetch_add(n, memory_order_relaxed);
+    AllocCounter::count.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+// Out of line so GCC does not pair an inlined free() with the builtin new and warn
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+#endif
+
+/**
+ * @class Benchmark
+ * @brief Microbenchmarks for the core structures, codecs and folder sorts.
+ *
+ * Each benchmark runs in batches until it has spent --bench-time ms inside
+ * its timed regions; setup such as building the files to insert is not
+ * timed. Results are printed as CSV, one row per benchmark:
+ *   benchmark,n,dist,entropy,ops,ns_per_op,alloc_bytes_per_op,allocs_per_op,ops_per_sec,mb_per_sec
+ * mb_per_sec is only filled in where an op processes a payload (codecs,
+ * version rebuilds), and the two alloc columns only in -DDRIVE_BENCH builds.
+ * For sorts one op is a whole sort of n files.
+ *
+ * Key distributions: seq (ascending), uniform, or zipf (s = 1, hot keys
+ * scattered over the ID range). Inserts always use every key once, in
+ * ascending order for seq and shuffled otherwise. Content is drawn
+ * uniformly from 2^entropy byte values, so entropy is in bits per byte.
+ */
+class Benchmark {
+public:
+    struct Config {
+        string filter = "all";     // Runs benchmarks whose name contains this
+        size_t n = 10000;
+        string dist = "uniform";
+        double entropy = 4.0;
+        int minMillis = 200;
+    };
+
+    static bool ValidDist(const string& d) { return d == "seq" || d == "uniform" || d == "zipf"; }
+
+private:
+    static const size_t CODEC_BLOCK = 64 * 1024;
+    static const size_t VERSION_SIZE = 4 * 1024;
+    static const int MAX_VERSIONS = 512;
+    static const int GRAPH_DEGREE = 16;  // Average friends per user in the graph benchmarks
+
+    // Accumulates time and allocations over the timed parts of a run
+    struct Timer {
+        chrono::steady_clock::time_point start;
+        uint64_t bytesAtStart = 0, allocsAtStart = 0;
+        long long ns = 0;
+        uint64_t bytes = 0, allocs = 0;
+
+        void Start() {
+#ifdef DRIVE_BENCH
+            bytesAtStart = AllocCounter::bytes.load(memory_order_relaxed);
+            allocsAtStart = AllocCounter::count.load(memory_order_relaxed);
+#endif
+            start = chrono::steady_clock::now();
+        }
+        void Stop() {
+            ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+#ifdef DRIVE_BENCH
+            bytes += AllocCounter::bytes.load(memory_order_relaxed) - bytesAtStart;
+            allocs += AllocCounter::count.load(memory_order_relaxed) - allocsAtStart;
+#endif
+        }
+    };
+
+#ifdef DRIVE_BENCH
+    static const bool COUNTS_ALLOCS = true;
+#else
+    static const bool COUNTS_ALLOCS = false;  // Allocation columns are left empty
+#endif
+
+    Config cfg;
+    mt19937_64 rng;
+    int ran;
+
+    /**
+     * @brief  count keys in [0, n) drawn from the configured distribution.
+     *         unique gives a permutation of [0, n) instead.
+     */
+    vector<int> Keys(size_t n, size_t count, bool unique) {
+        vector<int> keys(count);
+        if (cfg.dist == "seq") {
+            for (size_t i = 0; i < count; i++) keys[i] = i % n;
+        } else if (unique) {
+            for (size_t i = 0; i < count; i++) keys[i] = i % n;
+            shuffle(keys.begin(), keys.end(), rng);
+        } else if (cfg.dist == "uniform") {
+            uniform_int_distribution<int> pick(0, n - 1);
+            for (int& k : keys) k = pick(rng);
+        } else {
+            vector<double> cdf(n);
+            double sum = 0;
+            for (size_t r = 0; r < n; r++) cdf[r] = sum += 1.0 / (r + 1);
+            vector<int> idOfRank(n);
+            for (size_t r = 0; r < n; r++) idOfRank[r] = r;
+            shuffle(idOfRank.begin(), idOfRank.end(), rng);
+            uniform_real_distribution<double> u(0, sum);
+            for (int& k : keys) {
+                size_t r = lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin();
+                k = idOfRank[min(r, n - 1)];
+            }
+        }
+        return keys;
+    }
+
+    // Six or more letters, so names sharing a prefix are common as in a real directory
+    static string NameOf(int key) {
+        string s(6, 'a');
+        for (int i = 5; i >= 0 && key; i--, key /= 26) s[i] = 'a' + key % 26;
+        for (; key; key /= 26) s.insert(s.begin(), 'a' + key % 26);
+        return s;
+    }
+
+    string Content(size_t len) {
+        int symbols = max(1, min(256, (int)lround(pow(2.0, cfg.entropy))));
+        uniform_int_distribution<int> pick(0, symbols - 1);
+        string s(len, '\0');
+        for (char& c : s) c = (char)pick(rng);
+        return s;
+    }
+
+    // Files with IDs 1..n; sizes follow the key distribution (at most 8 KiB of content each)
+    vector<File> MakeFiles(size_t n) {
+        vector<int> keys = Keys(n, n, false);
+        vector<File> files(n);
+        for (size_t i = 0; i < n; i++) {
+            files[i].SetValues(i + 1, NameOf(keys[i]), "txt", "bench", string(keys[i] % 8192, 'a' + keys[i] % 26),
+                               1 + keys[i] % 10);
+        }
+        return files;
+    }
+
+    // batch(timer) runs one batch and returns {ops, payload bytes}
+    void Run(const string& name, size_t n, function<pair<uint64_t, uint64_t>(Timer&)> batch) {
+        if (cfg.filter != "all" && name.find(cfg.filter) == string::npos) return;
+        if (ran == 0) cout << "benchmark,n,dist,entropy,ops,ns_per_op,alloc_bytes_per_op,allocs_per_op,ops_per_sec,mb_per_sec\n";
+        Timer t;
+        uint64_t ops = 0, payload = 0;
+        long long minNs = (long long)cfg.minMillis * 1000000;
+        do {
+            pair<uint64_t, uint64_t> r = batch(t);
+            ops += r.first;
+            payload += r.second;
+        } while (t.ns < minNs);
+
+        double nsPerOp = ops ? (double)t.ns / ops : 0;
+        double seconds = t.ns / 1e9;
+        cout << name << "," << n << "," << cfg.dist << "," << cfg.entropy << "," << ops << ","
+             << fixed << setprecision(1) << nsPerOp << ",";
+        if (COUNTS_ALLOCS) {
+            cout << setprecision(1) << (ops ? (double)t.bytes / ops : 0) << ","
+                 << setprecision(3) << (ops ? (double)t.allocs / ops : 0) << ",";
+        } else {
+            cout << ",,";
+        }
+        cout << setprecision(0) << (seconds > 0 ? ops / seconds : 0) << ",";
+        if (payload) cout << setprecision(1) << (seconds > 0 ? payload / seconds / 1e6 : 0);
+        cout << "\n" << defaultfloat << flush;
+        ran++;
+    }
+
+    void HashTable() {
+        size_t n = cfg.n;
+        Run("hash.insert", n, [&](Timer& t) {
+            vector<File> files = MakeFiles(n);
+            vector<int> order = Keys(n, n, true);
+            HashTableFiles table;
+            t.Start();
+            for (int k : order) table.Insert(move(files[k]));
+            t.Stop();
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        HashTableFiles table;
+        vector<File> files = MakeFiles(n);
+        for (File& f : files) table.Insert(move(f));
+        vector<int> lookups = Keys(n, n, false);
+        Run("hash.search", n, [&](Timer& t) {
+            size_t found = 0;
+            t.Start();
+            for (int k : lookups) found += table.Search(k + 1) != nullptr;
+            t.Stop();
+            if (found != n) cerr << " [WARN] hash.search missed " << n - found << " keys\n";
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        Run("hash.delete", n, [&](Timer& t) {
+            HashTableFiles victims;
+            vector<File> files = MakeFiles(n);
+            for (File& f : files) victims.Insert(move(f));
+            vector<int> order = Keys(n, n, true);
+            t.Start();
+            for (int k : order) victims.Delete(k + 1);
+            t.Stop();
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+    }
+
+    void FolderTree() {
+        size_t n = cfg.n;
+        Run("folders.add", n, [&](Timer& t) {
+            vector<int> order = Keys(n, n, true);
+            vector<Folder> folders(n);
+            for (size_t i = 0; i < n; i++) folders[i].SetValues(NameOf(order[i]), order[i] + 1, "bench");
+            BPlusTreeFolders tree;
+            t.Start();
+            for (Folder& f : folders) tree.AddFolder(move(f));
+            t.Stop();
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        Run("folders.bulkload", n, [&](Timer& t) {
+            vector<Folder*> folders(n);
+            for (size_t i = 0; i < n; i++) {
+                folders[i] = new Folder();
+                folders[i]->SetValues(NameOf(i), i + 1, "bench");
+            }
+            BPlusTreeFolders tree;
+            t.Start();
+            tree.BulkLoad(folders);
+            t.Stop();
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        BPlusTreeFolders tree;
+        for (size_t i = 0; i < n; i++) {
+            Folder f;
+            f.SetValues(NameOf(i), i + 1, "bench");
+            tree.AddFolder(move(f));
+        }
+        vector<int> lookups = Keys(n, n, false);
+        Run("folders.get", n, [&](Timer& t) {
+            size_t found = 0;
+            t.Start();
+            for (int k : lookups) found += tree.GetFolder(k + 1) != nullptr;
+            t.Stop();
+            if (found != n) cerr << " [WARN] folders.get missed " << n - found << " keys\n";
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        // One op visits up to 64 folders starting at a looked-up ID
+        Run("folders.range", n, [&](Timer& t) {
+            size_t visited = 0;
+            t.Start();
+            for (int k : lookups) tree.ForEachInRange(k + 1, k + 64, [&visited](Folder& f) { visited += f.GetID() > 0; });
+            t.Stop();
+            if (visited < n) cerr << " [WARN] folders.range visited only " << visited << " folders\n";
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        Run("folders.remove", n, [&](Timer& t) {
+            BPlusTreeFolders victims;
+            for (size_t i = 0; i < n; i++) {
+                Folder f;
+                f.SetValues(NameOf(i), i + 1, "bench");
+                victims.AddFolder(move(f));
+            }
+            vector<int> order = Keys(n, n, true);
+            t.Start();
+            for (int k : order) victims.RemoveFolder(k + 1);
+            t.Stop();
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+    }
+
+    void UserTrie() {
+        size_t n = cfg.n;
+        vector<string> names(n);
+        for (size_t i = 0; i < n; i++) names[i] = NameOf(i);
+        Run("trie.insert", n, [&](Timer& t) {
+            vector<int> order = Keys(n, n, true);
+            TrieUsers trie;
+            t.Start();
+            for (int k : order) trie.Insert(names[k]);
+            t.Stop();
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        TrieUsers trie;
+        for (const string& s : names) trie.Insert(s);
+        vector<int> lookups = Keys(n, n, false);
+        vector<string> prefixes(n);
+        for (size_t i = 0; i < n; i++) prefixes[i] = names[lookups[i]].substr(0, names[lookups[i]].size() - 1);
+        Run("trie.autocomplete", n, [&](Timer& t) {
+            size_t found = 0;
+            t.Start();
+            for (const string& p : prefixes) found += trie.AutoComplete(p).size();
+            t.Stop();
+            if (found < n) cerr << " [WARN] trie.autocomplete found only " << found << " names\n";
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+
+        // Scores follow the key distribution, as friend counts would
+        Run("trie.rescore", n, [&](Timer& t) {
+            t.Start();
+            for (size_t i = 0; i < n; i++) trie.SetScore(names[lookups[i]], i);
+            t.Stop();
+            return make_pair((uint64_t)n, (uint64_t)0);
+        });
+    }
+
+    // Friendships between n users; one endpoint follows the key distribution, so zipf gives hubs
+    void Graph() {
+        uint32_t n = max<size_t>(cfg.n, 2);
+        size_t m = (size_t)n * GRAPH_DEGREE / 2;
+        vector<int> hubs = Keys(n, m, false);
+        vector<pair<uint32_t, uint32_t>> edges(m);
+        uniform_int_distribution<uint32_t> pick(0, n - 1);
+        for (size_t i = 0; i < m; i++) edges[i] = {(uint32_t)hubs[i], pick(rng)};
+
+        Run("graph.addedge", n, [&](Timer& t) {
+            FriendGraph g;
+            g.Resize(n);
+            t.Start();
+            for (const auto& e : edges) g.AddEdge(e.first, e.second);
+            t.Stop();
+            return make_pair((uint64_t)m, (uint64_t)0);
+        });
+
+        Run("graph.union", n, [&](Timer& t) {
+            FriendComponents c;
+            c.Resize(n);
+            t.Start();
+            for (const auto& e : edges) c.Union(e.first, e.second);
+            t.Stop();
+            return make_pair((uint64_t)m, (uint64_t)0);
+        });
+
+        FriendGraph g;
+        g.Resize(n);
+        for (const auto& e : edges) g.AddEdge(e.first, e.second);
+        g.Compact();
+        Run("graph.hasedge", n, [&](Timer& t) {
+            size_t found = 0;
+            t.Start();
+            for (const auto& e : edges) found += g.HasEdge(e.second, e.first);
+            t.Stop();
+            if (found < g.EdgeCount()) cerr << " [WARN] graph.hasedge found only " << found << " edges\n";
+            return make_pair((uint64_t)m, (uint64_t)0);
+        });
+
+        // Users follow the key distribution, so zipf keeps asking for the hubs
+        vector<int> askers = Keys(n, 1024, false);
+        Run("graph.recommend", n, [&](Timer& t) {
+            FriendRecommender rec;
+            size_t found = 0;
+            t.Start();
+            for (int u : askers) found += rec.Recommend(g, u, RECOMMEND_LIMIT).size();
+            t.Stop();
+            if (!found) cerr << " [WARN] graph.recommend found nothing\n";
+            return make_pair((uint64_t)askers.size(), (uint64_t)0);
+        });
+
+        // Shortest path between a key-distributed user and a uniform one
+        vector<int> sources = Keys(n, 256, false);
+        Run("graph.path", n, [&](Timer& t) {
+            PathFinder finder;
+            size_t found = 0;
+            t.Start();
+            for (int src : sources) found += !finder.Shortest(g, src, pick(rng), UINT32_MAX).empty();
+            t.Stop();
+            if (!found) cerr << " [WARN] graph.path found nothing\n";
+            return make_pair((uint64_t)sources.size(), (uint64_t)0);
+        });
+
+        // One op is one edge scanned by a BFS over every component
+        Run("graph.bfs", n, [&](Timer& t) {
+            vector<bool> seen(n, false);
+            vector<uint32_t> q;
+            q.reserve(n);
+            uint64_t scanned = 0;
+            t.Start();
+            for (uint32_t s = 0; s < n; s++) {
+                if (seen[s]) continue;
+                seen[s] = true;
+                q.push_back(s);
+                for (size_t head = q.size() - 1; head < q.size(); head++) {
+                    g.ForEachNeighbor(q[head], [&](uint32_t v) {
+                        scanned++;
+                        if (!seen[v]) {
+                            seen[v] = true;
+                            q.push_back(v);
+                        }
+                    });
+                }
+            }
+            t.Stop();
+            return make_pair(max<uint64_t>(scanned, 1), (uint64_t)0);
+        });
+    }
+
+    void Versions() {
+        int count = (int)min<size_t>(max<size_t>(cfg.n, 1), MAX_VERSIONS);
+        File f;
+        string content = Content(VERSION_SIZE);
+        f.SetValues(1, "bench", "txt", "bench", content);
+        uniform_int_distribution<size_t> at(0, VERSION_SIZE - 16);
+        for (int v = 2; v <= count; v++) {
+            string edit = Content(16);
+            content.replace(at(rng), 16, edit);
+            f.AddVersion(content);
+        }
+        vector<int> picks = Keys(count, 1024, false);
+        Run("version.get", count, [&](Timer& t) {
+            size_t bytes = 0;
+            t.Start();
+            for (int k : picks) bytes += f.GetVersionContent(k + 1).size();
+            t.Stop();
+            return make_pair((uint64_t)picks.size(), (uint64_t)bytes);
+        });
+    }
+
+    void Codecs() {
+        string raw = Content(CODEC_BLOCK);
+        for (int id = CODEC_RLE; id < CODEC_COUNT; id++) {
+            const Codec& codec = CodecRegistry::Get((CodecID)id);
+            string name = codec.Name();
+            transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+            string packed;
+            Run("codec." + name + ".compress", CODEC_BLOCK, [&](Timer& t) {
+                t.Start();
+                for (int i = 0; i < 16; i++) {
+                    packed.clear();
+                    codec.Compress(raw.data(), raw.size(), packed);
+                }
+                t.Stop();
+                return make_pair((uint64_t)16, (uint64_t)16 * raw.size());
+            });
+
+            string out(raw.size(), '\0');
+            Run("codec." + name + ".decompress", CODEC_BLOCK, [&](Timer& t) {
+                bool ok = true;
+                t.Start();
+                for (int i = 0; i < 16; i++) ok &= codec.Decompress(packed.data(), packed.size(), &out[0], out.size());
+                t.Stop();
+                if (!ok || out != raw) cerr << " [WARN] " << codec.Name() << " round trip failed\n";
+                return make_pair((uint64_t)16, (uint64_t)16 * raw.size());
+            });
+        }
+    }
+
+    void Sorts() {
+        size_t n = cfg.n;
+        HashTableFiles table;
+        vector<File> files = MakeFiles(n);
+        for (File& f : files) table.Insert(move(f));
+
+        typedef void (HashTableFiles::*SortFn)(bool);
+        static const pair<const char*, SortFn> sorts[] = {
+            {"sort.bubble", &HashTableFiles::SortBubbleSize},
+            {"sort.insertion", &HashTableFiles::SortInsertionSize},
+            {"sort.selection", &HashTableFiles::SortSelectionSize},
+            {"sort.merge", &HashTableFiles::SortMergeSize},
+            {"sort.heap", &HashTableFiles::SortHeapSize},
+            {"sort.counting", &HashTableFiles::SortCountingSize},
+            {"sort.quick", &HashTableFiles::SortQuickName},
+            {"sort.radix", &HashTableFiles::SortRadixName},
+        };
+        for (auto& s : sorts) {
+            Run(s.first, n, [&](Timer& t) {
+                t.Start();
+                (table.*s.second)(false);
+                t.Stop();
+                return make_pair((uint64_t)1, (uint64_t)0);
+            });
+        }
+    }
+
+public:
+    Benchmark(const Config& c) : cfg(c), rng(42), ran(0) {}
+
+    // Returns the number of benchmarks run
+    int RunAll() {
+        HashTable();
+        FolderTree();
+        UserTrie();
+        Graph();
+        Versions();
+        Codecs();
+        Sorts();
+        return ran;
+    }
+};
+
+// Parses a whole decimal argument in [1, max]; anything else is rejected
+static bool ParsePositive(const string& value, long long max, long long& out) {
+    if (value.empty()) return false;
+    char* end;
+    errno = 0;
+    long long v = strtoll(value.c_str(), &end, 10);
+    if (errno || *end != '\0' || v <= 0 || v > max) return false;
+    out = v;
+    return true;
+}
+
+int main(int argc, char* argv[]){
     srand(time(0));
-    GoogleDriveSystem app;
+    string scriptPath, snapshotPath;
+    bool bench = false;
+    Benchmark::Config benchConfig;
+    for (int i = 1; i < argc; i += 2) {
+        string flag = argv[i], value = i + 1 < argc ? argv[i + 1] : "";
+        bool ok = true;
+        if (i + 1 == argc) ok = false;  // Every flag takes a value
+        else if (flag == "--script") scriptPath = value;
+        else if (flag == "--snapshot") snapshotPath = value;
+        else if (flag == "--bench") {
+            bench = true;
+            benchConfig.filter = value;
+        }
+        else if (flag == "--bench-n") {
+            long long n;
+            if ((ok = ParsePositive(value, INT_MAX, n))) benchConfig.n = n;  // Keys are ints
+        }
+        else if (flag == "--bench-dist") ok = Benchmark::ValidDist(benchConfig.dist = value);
+        else if (flag == "--bench-entropy") {
+            char* end;
+            double bits = strtod(value.c_str(), &end);
+            ok = !value.empty() && *end == '\0' && bits >= 0 && bits <= 8;  // Also rejects NaN
+            if (ok) benchConfig.entropy = bits;
+        }
+        else if (flag == "--bench-time") {
+            long long ms;
+            if ((ok = ParsePositive(value, INT_MAX, ms))) benchConfig.minMillis = ms;
+        }
+        else ok = false;
+        if (!ok) {
+            cerr << " Usage: " << argv[0] << " [--script <file|->] [--snapshot <file>]\n"
+                 << "        " << argv[0] << " --bench <all|name> [--bench-n <files>] [--bench-dist <seq|uniform|zipf>]\n"
+                 << "              [--bench-entropy <bits per byte, 0-8>] [--bench-time <ms per benchmark>]\n";
+            return 1;
+        }
+    }
+
+    if (bench) {
+        Benchmark runner(benchConfig);
+        if (runner.RunAll() == 0) {
+            cerr << " [ERROR] No benchmark matches '" << benchConfig.filter << "'.\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!scriptPath.empty()) {
+        // Scripted runs start empty and unjournaled unless a snapshot is named explicitly
+        UserGraph network;
+        if (!snapshotPath.empty() && !RecoverDrive(network, snapshotPath)) return 1;
+        ScriptRunner runner(network);
+        if (scriptPath == "-") {
+            runner.Run(cin);
+        } else {
+            ifstream script(scriptPath);
+            if (!script) {
+                cerr << " [ERROR] Cannot open script '" << scriptPath << "'.\n";
+                return 1;
+            }
+            runner.Run(script);
+        }
+        if (!snapshotPath.empty()) SaveSnapshot(network, snapshotPath);
+        return 0;
+    }
+
+    GoogleDriveSystem app(snapshotPath.empty() ? SNAPSHOT_FILE : snapshotPath);
+    if (!app.Recovered()) return 1;
     app.Run();
     return 0;
-}
\ No newline at end of file
+}